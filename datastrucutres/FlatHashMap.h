@@ -0,0 +1,423 @@
+#ifndef FLATHASHMAP_H
+#define FLATHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// open addressing hash map with Robin Hood linear probing, a flat alternative to std::unordered_map.
+// all entries live in one array, so an insert does not allocate a node and a lookup walks
+// neighbouring slots instead of chasing pointers.
+//
+// - the table has a power of two number of home slots, keys are spread over them with fibonacci
+//   hashing (multiply, keep the top bits), so std::hash<int> being the identity does not matter
+// - Robin Hood: an entry that is further from its home slot than the one it probes past takes that
+//   slot, and the displaced entry moves on. probe lengths stay short and even, and a lookup can stop
+//   as soon as it meets an entry closer to home than the key it looks for would be
+// - erase shifts the following entries of the probe chain back by one slot (backward shift), so
+//   there are no tombstones and lookups never slow down after many erases
+// - probes never wrap around: maxProbe extra slots follow the home slots (about 8*log2 of the table
+//   size), and a probe that would need more than that grows the table. erasing while iterating
+//   therefore never revisits or skips an entry
+// - a bad hash (many keys with the same hash value) gives long probe chains in a table that is
+//   still mostly empty. doubling would not spread those keys, so in that case the overflow area
+//   grows instead: lookups get slower, like unordered_map's long bucket chains, but memory stays
+//   proportional to the number of keys. past 65535 keys in one chain insert throws length_error
+//
+// the API follows unordered_map (find, count, contains, at, operator[], insert, emplace,
+// try_emplace, insert_or_assign, erase, reserve, rehash, load factors, iterators). differences:
+// entries are std::pair<K, V> rather than pair<const K, V> because they move between slots, so
+// keys must not be changed through an iterator; any insert or erase can move entries and
+// invalidates iterators, pointers and references (except erase(it), which returns the next one);
+// the max load factor is capped at 0.95.
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class FlatHashMap {
+    public:
+        using key_type = K;
+        using mapped_type = V;
+        using value_type = std::pair<K, V>;
+        using size_type = size_t;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+
+        template <bool Const>
+        class Iterator {
+            friend class FlatHashMap;
+            template <bool> friend class Iterator;
+            using Map = std::conditional_t<Const, const FlatHashMap, FlatHashMap>;
+            Map* map = nullptr;
+            size_t idx = 0;
+
+            Iterator(Map* map, size_t idx) : map(map), idx(idx) {}
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::pair<K, V>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+                using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+                Iterator() = default;
+
+                operator Iterator<true>() const {
+                    return Iterator<true>(map, idx);
+                }
+
+                reference operator*() const {
+                    return map->slots[idx];
+                }
+
+                pointer operator->() const {
+                    return &map->slots[idx];
+                }
+
+                Iterator& operator++(){
+                    idx = map->nextOccupied(idx + 1);
+                    return *this;
+                }
+
+                Iterator operator++(int){
+                    Iterator old = *this;
+                    ++*this;
+                    return old;
+                }
+
+                bool operator==(const Iterator& other) const {
+                    return idx == other.idx && map == other.map;
+                }
+
+                bool operator!=(const Iterator& other) const {
+                    return !(*this == other);
+                }
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        FlatHashMap() = default;
+
+        explicit FlatHashMap(size_t buckets, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+            : hash(hash), equal(equal){
+            if (buckets > 0) rehash(buckets);
+        }
+
+        FlatHashMap(std::initializer_list<value_type> values) {
+            reserve(values.size());
+            for (const value_type& value : values) insert(value);
+        }
+
+        FlatHashMap(const FlatHashMap& other)
+            : maxLoad(other.maxLoad), hash(other.hash), equal(other.equal){
+            // same capacity, so every entry can be copied into the same slot
+            if (other.homeSlots == 0) return;
+            allocate(other.homeSlots, other.maxProbe);
+            for (size_t i=0; i<totalSlots(); i++){
+                if (other.dist[i] == 0) continue;
+                new (slots + i) value_type(other.slots[i]);
+                dist[i] = other.dist[i];
+            }
+            entries = other.entries;
+        }
+
+        FlatHashMap(FlatHashMap&& other) noexcept {
+            swap(other);
+        }
+
+        FlatHashMap& operator=(FlatHashMap other) noexcept {
+            // copy and swap, other is a copy or was moved from
+            swap(other);
+            return *this;
+        }
+
+        ~FlatHashMap(){
+            destroy();
+        }
+
+        void swap(FlatHashMap& other) noexcept {
+            std::swap(slots, other.slots);
+            std::swap(dist, other.dist);
+            std::swap(homeSlots, other.homeSlots);
+            std::swap(maxProbe, other.maxProbe);
+            std::swap(shift, other.shift);
+            std::swap(entries, other.entries);
+            std::swap(maxLoad, other.maxLoad);
+            std::swap(hash, other.hash);
+            std::swap(equal, other.equal);
+        }
+
+        iterator begin(){ return iterator(this, nextOccupied(0)); }
+        iterator end(){ return iterator(this, totalSlots()); }
+        const_iterator begin() const { return const_iterator(this, nextOccupied(0)); }
+        const_iterator end() const { return const_iterator(this, totalSlots()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_t size() const { return entries; }
+        bool empty() const { return entries == 0; }
+        size_t bucket_count() const { return homeSlots; }
+        float load_factor() const { return homeSlots == 0 ? 0 : (float)entries / homeSlots; }
+        float max_load_factor() const { return maxLoad; }
+
+        void max_load_factor(float load){
+            maxLoad = std::min(std::max(load, 0.05f), 0.95f);
+            if (entries > homeSlots * maxLoad) rehash(0);
+        }
+
+        void reserve(size_t n){
+            rehash((size_t)(n / maxLoad) + 1);
+        }
+
+        void rehash(size_t buckets){
+            // at least `buckets` home slots and enough for the current entries, rounded up to a power of two
+            size_t needed = std::max(buckets, (size_t)(entries / maxLoad) + 1);
+            size_t newSlots = 8;
+            while (newSlots < needed) newSlots *= 2;
+            if (newSlots == homeSlots) return;
+            // an overflow area that was grown for a bad hash stays at least as big
+            rebuild(newSlots, std::max(defaultProbe(newSlots), homeSlots == 0 ? 0 : maxProbe));
+        }
+
+        void clear(){
+            // keeps the capacity, like unordered_map
+            for (size_t i=0; i<totalSlots(); i++){
+                if (dist[i] != 0) slots[i].~value_type();
+                dist[i] = 0;
+            }
+            entries = 0;
+        }
+
+        iterator find(const K& key){
+            return iterator(this, findIndex(key));
+        }
+
+        const_iterator find(const K& key) const {
+            return const_iterator(this, findIndex(key));
+        }
+
+        size_t count(const K& key) const {
+            return findIndex(key) != totalSlots();
+        }
+
+        bool contains(const K& key) const {
+            return findIndex(key) != totalSlots();
+        }
+
+        V& at(const K& key){
+            size_t idx = findIndex(key);
+            if (idx == totalSlots()) throw std::out_of_range("FlatHashMap::at: key not found");
+            return slots[idx].second;
+        }
+
+        const V& at(const K& key) const {
+            size_t idx = findIndex(key);
+            if (idx == totalSlots()) throw std::out_of_range("FlatHashMap::at: key not found");
+            return slots[idx].second;
+        }
+
+        V& operator[](const K& key){
+            return try_emplace(key).first->second;
+        }
+
+        V& operator[](K&& key){
+            return try_emplace(std::move(key)).first->second;
+        }
+
+        template <typename KeyArg, typename... Args>
+        std::pair<iterator, bool> try_emplace(KeyArg&& key, Args&&... args){
+            // the value is only constructed when the key is new
+            size_t idx = findIndex(key);
+            if (idx != totalSlots()) return {iterator(this, idx), false};
+            if (entries + 1 > homeSlots * maxLoad) rehash(homeSlots * 2);
+            idx = insertNew(value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArg>(key)),
+                                       std::forward_as_tuple(std::forward<Args>(args)...)));
+            return {iterator(this, idx), true};
+        }
+
+        template <typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args){
+            value_type value(std::forward<Args>(args)...);
+            size_t idx = findIndex(value.first);
+            if (idx != totalSlots()) return {iterator(this, idx), false};
+            if (entries + 1 > homeSlots * maxLoad) rehash(homeSlots * 2);
+            return {iterator(this, insertNew(std::move(value))), true};
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value){
+            return try_emplace(value.first, value.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value){
+            return try_emplace(std::move(value.first), std::move(value.second));
+        }
+
+        template <typename M>
+        std::pair<iterator, bool> insert_or_assign(const K& key, M&& value){
+            std::pair<iterator, bool> result = try_emplace(key, std::forward<M>(value));
+            if (!result.second) result.first->second = std::forward<M>(value);
+            return result;
+        }
+
+        size_t erase(const K& key){
+            size_t idx = findIndex(key);
+            if (idx == totalSlots()) return 0;
+            eraseIndex(idx);
+            return 1;
+        }
+
+        iterator erase(const_iterator pos){
+            // the backward shift moves the next entry of the chain into pos, if there is one
+            size_t idx = pos.idx;
+            eraseIndex(idx);
+            return iterator(this, nextOccupied(idx));
+        }
+
+        iterator erase(iterator pos){
+            return erase(const_iterator(pos));
+        }
+
+    private:
+        value_type* slots = nullptr;
+        std::vector<uint16_t> dist; // 0 = empty slot, otherwise 1 + distance from the entry's home slot
+        size_t homeSlots = 0;       // power of two
+        size_t maxProbe = 0;        // extra slots after the home slots, also the longest allowed probe
+        int shift = 64;
+        size_t entries = 0;
+        float maxLoad = 0.875f;
+        Hash hash;
+        KeyEqual equal;
+
+        static constexpr size_t maxProbeLimit = 65535; // largest distance dist can hold
+
+        static size_t defaultProbe(size_t homeSlots){
+            size_t log2 = 0;
+            for (size_t s=homeSlots; s>1; s/=2) log2++;
+            return std::min(homeSlots, 16 + 8*log2);
+        }
+
+        size_t totalSlots() const {
+            return homeSlots + maxProbe;
+        }
+
+        size_t homeSlot(const K& key) const {
+            // fibonacci hashing: the top bits of hash * 2^64/phi
+            return (size_t)(((uint64_t)hash(key) * 11400714819323198485ull) >> shift);
+        }
+
+        size_t nextOccupied(size_t idx) const {
+            while (idx < totalSlots() && dist[idx] == 0) idx++;
+            return idx;
+        }
+
+        size_t findIndex(const K& key) const {
+            // returns totalSlots() when the key is missing
+            if (entries == 0) return totalSlots();
+            size_t idx = homeSlot(key);
+            size_t d = 1;
+            while (dist[idx] >= d){
+                if (dist[idx] == d && equal(slots[idx].first, key)) return idx;
+                idx++;
+                d++;
+            }
+            return totalSlots();
+        }
+
+        size_t insertNew(value_type&& value){
+            // inserts a key that is not in the map yet, returns the slot it ended up in. the new entry
+            // goes before the first entry that is closer to its home than the new one would be, and the
+            // rest of the cluster up to the next empty slot moves back by one. everything is checked
+            // before anything moves, so when the probe does not fit the table can grow and retry
+            while (true){
+                size_t idx = homeSlot(value.first);
+                size_t d = 1;
+                while (d <= maxProbe && dist[idx] >= d){
+                    idx++;
+                    d++;
+                }
+                size_t end = idx;
+                bool fits = d <= maxProbe;
+                while (fits && end < totalSlots() && dist[end] != 0){
+                    fits = dist[end] < maxProbe;
+                    end++;
+                }
+                if (fits && end < totalSlots()){
+                    for (size_t i=end; i>idx; i--){
+                        new (slots + i) value_type(std::move(slots[i-1]));
+                        slots[i-1].~value_type();
+                        dist[i] = dist[i-1] + 1;
+                    }
+                    new (slots + idx) value_type(std::move(value));
+                    dist[idx] = d;
+                    entries++;
+                    return idx;
+                }
+                growForProbe();
+            }
+        }
+
+        void growForProbe(){
+            // a probe ran past the overflow area. in a reasonably full table that just means it is time
+            // to grow. in a mostly empty one many keys share a hash value, and doubling would only
+            // allocate more without spreading them, so the overflow area gets longer instead
+            if (load_factor() >= maxLoad / 2) rebuild(homeSlots * 2, std::max(defaultProbe(homeSlots * 2), maxProbe));
+            else if (maxProbe < maxProbeLimit) rebuild(homeSlots, std::min(maxProbe * 2, maxProbeLimit));
+            else throw std::length_error("FlatHashMap: too many keys share a hash value");
+        }
+
+        void rebuild(size_t newSlots, size_t newProbe){
+            value_type* oldSlots = slots;
+            std::vector<uint16_t> oldDist = std::move(dist);
+            size_t oldTotal = totalSlots();
+            allocate(newSlots, newProbe);
+            entries = 0;
+            for (size_t i=0; i<oldTotal; i++){
+                if (oldDist[i] == 0) continue;
+                insertNew(std::move(oldSlots[i]));
+                oldSlots[i].~value_type();
+            }
+            if (oldSlots != nullptr) std::allocator<value_type>().deallocate(oldSlots, oldTotal);
+        }
+
+        void eraseIndex(size_t idx){
+            slots[idx].~value_type();
+            size_t next = idx + 1;
+            while (next < totalSlots() && dist[next] > 1){
+                new (slots + idx) value_type(std::move(slots[next]));
+                slots[next].~value_type();
+                dist[idx] = dist[next] - 1;
+                idx = next++;
+            }
+            dist[idx] = 0;
+            entries--;
+        }
+
+        void allocate(size_t newSlots, size_t newProbe){
+            homeSlots = newSlots;
+            maxProbe = newProbe;
+            shift = 64;
+            for (size_t s=newSlots; s>1; s/=2) shift--;
+            slots = std::allocator<value_type>().allocate(totalSlots());
+            dist.assign(totalSlots(), 0);
+        }
+
+        void destroy(){
+            if (slots == nullptr) return;
+            for (size_t i=0; i<totalSlots(); i++){
+                if (dist[i] != 0) slots[i].~value_type();
+            }
+            std::allocator<value_type>().deallocate(slots, totalSlots());
+            slots = nullptr;
+        }
+};
+
+#endif // FLATHASHMAP_H
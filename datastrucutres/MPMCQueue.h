@@ -0,0 +1,236 @@
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <utility>
+
+// bounded lock-free ring queues for passing tasks and results between threads.
+//
+// MPMCQueue: any number of producers and consumers (Vyukov's bounded queue). every slot has a
+// sequence number that says whose turn it is: slot i is free for the push at position pos when its
+// sequence equals pos, and holds a value for the pop at position pos when it equals pos + 1. a push
+// claims its position with one compare-exchange on head, a pop with one on tail, then the slot's
+// sequence is published with release so the value is visible to the other side. no locks, and
+// threads only contend on the same counter when they push (or pop) at the same time.
+//
+// SPSCQueue: the fast path for exactly one producer thread and one consumer thread. no
+// compare-exchange and no per-slot sequence, each side owns its index and only reads the other
+// one when its cached copy says the queue looks full (or empty).
+//
+// head and tail sit on their own cache lines, so producers and consumers do not invalidate each
+// other's line on every operation. capacity is rounded up to a power of two. try_push/try_pop never
+// block and return false when the queue is full/empty, push/pop spin and then yield until they
+// succeed.
+
+const size_t cacheLineSize = 64;
+
+inline void queueBackoff(int& spins){
+    // spin a little, then give the core away (needed when there are more threads than cores)
+    if (++spins > 16) std::this_thread::yield();
+}
+
+inline size_t queueCapacity(size_t capacity){
+    size_t rounded = 2;
+    while (rounded < capacity) rounded *= 2;
+    return rounded;
+}
+
+template <typename T>
+class MPMCQueue {
+    struct Slot {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value(){
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    Slot* slots;
+    size_t mask;
+    alignas(cacheLineSize) std::atomic<size_t> head{0}; // next position to push
+    alignas(cacheLineSize) std::atomic<size_t> tail{0}; // next position to pop
+    char padding[cacheLineSize - sizeof(std::atomic<size_t>)];
+
+    public:
+        explicit MPMCQueue(size_t capacity){
+            size_t size = queueCapacity(capacity);
+            mask = size - 1;
+            slots = new Slot[size];
+            for (size_t i=0; i<size; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+        ~MPMCQueue(){
+            // destroy whatever was never popped
+            for (size_t pos=tail.load(); pos!=head.load(); pos++) slots[pos & mask].value()->~T();
+            delete[] slots;
+        }
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args){
+            size_t pos = head.load(std::memory_order_relaxed);
+            while (true){
+                Slot& slot = slots[pos & mask];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0){
+                    // the slot is free for this position, try to claim it
+                    if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        new (slot.storage) T(std::forward<Args>(args)...);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0){
+                    // the slot still holds the value from one lap ago: full
+                    return false;
+                }
+                else {
+                    // another producer took this position, move on to the current one
+                    pos = head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_push(const T& value){
+            return try_emplace(value);
+        }
+
+        bool try_push(T&& value){
+            return try_emplace(std::move(value));
+        }
+
+        bool try_pop(T& out){
+            size_t pos = tail.load(std::memory_order_relaxed);
+            while (true){
+                Slot& slot = slots[pos & mask];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+                if (diff == 0){
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        out = std::move(*slot.value());
+                        slot.value()->~T();
+                        // hand the slot to the push one lap ahead
+                        slot.sequence.store(pos + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0){
+                    // nothing pushed at this position yet: empty
+                    return false;
+                }
+                else {
+                    pos = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void push(T value){
+            int spins = 0;
+            while (!try_push(std::move(value))) queueBackoff(spins);
+        }
+
+        void pop(T& out){
+            int spins = 0;
+            while (!try_pop(out)) queueBackoff(spins);
+        }
+
+        size_t capacity() const {
+            return mask + 1;
+        }
+
+        size_t size() const {
+            // only a snapshot while other threads are pushing or popping
+            size_t pushed = head.load(std::memory_order_acquire);
+            size_t popped = tail.load(std::memory_order_acquire);
+            return pushed > popped ? pushed - popped : 0;
+        }
+};
+
+template <typename T>
+class SPSCQueue {
+    T* values;
+    size_t mask;
+    alignas(cacheLineSize) std::atomic<size_t> head{0}; // written by the producer only
+    size_t cachedTail = 0;                              // producer's last look at tail
+    alignas(cacheLineSize) std::atomic<size_t> tail{0}; // written by the consumer only
+    size_t cachedHead = 0;                              // consumer's last look at head
+    char padding[cacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    public:
+        explicit SPSCQueue(size_t capacity){
+            size_t size = queueCapacity(capacity);
+            mask = size - 1;
+            values = static_cast<T*>(::operator new(size * sizeof(T), std::align_val_t(alignof(T))));
+        }
+
+        SPSCQueue(const SPSCQueue&) = delete;
+        SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+        ~SPSCQueue(){
+            for (size_t pos=tail.load(); pos!=head.load(); pos++) values[pos & mask].~T();
+            ::operator delete(values, std::align_val_t(alignof(T)));
+        }
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args){
+            size_t pos = head.load(std::memory_order_relaxed);
+            if (pos - cachedTail > mask){
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (pos - cachedTail > mask) return false;
+            }
+            new (values + (pos & mask)) T(std::forward<Args>(args)...);
+            head.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_push(const T& value){
+            return try_emplace(value);
+        }
+
+        bool try_push(T&& value){
+            return try_emplace(std::move(value));
+        }
+
+        bool try_pop(T& out){
+            size_t pos = tail.load(std::memory_order_relaxed);
+            if (pos == cachedHead){
+                cachedHead = head.load(std::memory_order_acquire);
+                if (pos == cachedHead) return false;
+            }
+            T* value = values + (pos & mask);
+            out = std::move(*value);
+            value->~T();
+            tail.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        void push(T value){
+            int spins = 0;
+            while (!try_push(std::move(value))) queueBackoff(spins);
+        }
+
+        void pop(T& out){
+            int spins = 0;
+            while (!try_pop(out)) queueBackoff(spins);
+        }
+
+        size_t capacity() const {
+            return mask + 1;
+        }
+
+        size_t size() const {
+            size_t pushed = head.load(std::memory_order_acquire);
+            size_t popped = tail.load(std::memory_order_acquire);
+            return pushed > popped ? pushed - popped : 0;
+        }
+};
+
+#endif // MPMCQUEUE_H
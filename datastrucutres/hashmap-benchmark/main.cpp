@@ -0,0 +1,173 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
+#include "../FlatHashMap.h"
+
+using std::cout, std::vector, std::string;
+using std::chrono::high_resolution_clock, std::chrono::duration_cast, std::chrono::nanoseconds;
+
+// FlatHashMap vs std::unordered_map<int, int>: insert, successful lookup, failed lookup, iteration and
+// erase, for several table sizes and load factors. the flat map gets exactly `capacity` home slots
+// and capacity * load keys, so its load factor is the one in the table. unordered_map gets the same
+// keys with reserve(keys). every operation's result is checked: all keys found with their value, no
+// false hits, every entry iterated once and every erase succeeded. each cell is the median of `reps`
+// runs in ns per operation, appended to timingsHashMap.csv.
+
+struct OpTimings {
+    double insert = 0;
+    double hit = 0;
+    double miss = 0;
+    double iterate = 0;
+    double erase = 0;
+    bool correct = true;
+};
+
+template <typename Map> OpTimings timeOperations(const vector<int>& keys, const vector<int>& missing, size_t capacity);
+void prepare(FlatHashMap<int, int>& map, size_t capacity);
+void prepare(std::unordered_map<int, int>& map, size_t keys);
+double perOp(high_resolution_clock::time_point start, high_resolution_clock::time_point stop, size_t ops);
+
+vector<size_t> capacities = {1 << 10, 1 << 14, 1 << 17, 1 << 20};
+vector<double> loadFactors = {0.5, 0.75, 0.9};
+vector<string> operations = {"insert", "hit", "miss", "iterate", "erase"};
+int reps = 3;
+uint64_t checksum = 0; // keeps the iteration from being optimized away
+
+int main(){
+    std::ofstream file;
+    file.open("timingsHashMap.csv", std::ios::app);
+    if (!file.is_open()) {
+        cout << "Error opening timingsHashMap.csv for writing.\n";
+        return 1;
+    }
+    file << "map,keys,loadFactor,operation,nsPerOp\n";
+    std::mt19937 rng(42);
+    bool allCorrect = true;
+    for (size_t capacity : capacities) {
+        for (double load : loadFactors) {
+            size_t count = capacity * load;
+            // distinct random keys, the second half is never inserted and serves the failed lookups
+            std::unordered_set<int> seen;
+            vector<int> keys;
+            while (keys.size() < 2*count) {
+                int key = rng();
+                if (seen.insert(key).second) keys.push_back(key);
+            }
+            vector<int> missing(keys.begin() + count, keys.end());
+            keys.resize(count);
+
+            vector<OpTimings> flat;
+            vector<OpTimings> chained;
+            for (int rep = 0; rep < reps; rep++) {
+                flat.push_back(timeOperations<FlatHashMap<int, int>>(keys, missing, capacity));
+                chained.push_back(timeOperations<std::unordered_map<int, int>>(keys, missing, capacity));
+                if (!flat.back().correct || !chained.back().correct) {
+                    cout << (flat.back().correct ? "unordered_map" : "FlatHashMap") << " gave wrong results for "
+                         << count << " keys at load " << load << "\n";
+                    allCorrect = false;
+                }
+            }
+
+            cout << count << " keys, load " << load << ":";
+            for (const string& operation : operations) {
+                for (int m = 0; m < 2; m++) {
+                    vector<OpTimings>& runs = m == 0 ? flat : chained;
+                    vector<double> timings;
+                    for (OpTimings& run : runs) {
+                        if (operation == "insert") timings.push_back(run.insert);
+                        else if (operation == "hit") timings.push_back(run.hit);
+                        else if (operation == "miss") timings.push_back(run.miss);
+                        else if (operation == "iterate") timings.push_back(run.iterate);
+                        else timings.push_back(run.erase);
+                    }
+                    std::sort(timings.begin(), timings.end());
+                    double timing = timings[reps/2];
+                    file << (m == 0 ? "flat" : "unordered") << "," << count << "," << load << "," << operation
+                         << "," << timing << "\n";
+                    cout << (m == 0 ? " " + operation + " " : "/") << timing;
+                }
+            }
+            cout << " ns (flat/unordered)\n";
+        }
+    }
+    file.close();
+    cout << "checksum " << checksum << "\n";
+    if (!allCorrect) return 1;
+    cout << "All hash map operations completed.\n";
+    return 0;
+}
+
+template <typename Map>
+OpTimings timeOperations(const vector<int>& keys, const vector<int>& missing, size_t capacity){
+    OpTimings timings;
+    Map map;
+    if constexpr (std::is_same_v<Map, FlatHashMap<int, int>>) prepare(map, capacity);
+    else prepare(map, keys.size());
+
+    size_t inserted = 0;
+    auto start = high_resolution_clock::now();
+    for (int key : keys) inserted += map.insert({key, key}).second;
+    auto stop = high_resolution_clock::now();
+    timings.insert = perOp(start, stop, keys.size());
+    timings.correct = inserted == keys.size() && map.size() == keys.size();
+
+    // look the keys up in a different order than they were inserted
+    vector<int> lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(7));
+    // every lookup has to find its key with the value it was inserted with
+    size_t found = 0;
+    start = high_resolution_clock::now();
+    for (int key : lookups) {
+        auto it = map.find(key);
+        if (it != map.end() && it->second == key) found++;
+    }
+    stop = high_resolution_clock::now();
+    timings.hit = perOp(start, stop, lookups.size());
+    timings.correct = timings.correct && found == lookups.size();
+
+    size_t falseHits = 0;
+    start = high_resolution_clock::now();
+    for (int key : missing) falseHits += map.count(key);
+    stop = high_resolution_clock::now();
+    timings.miss = perOp(start, stop, missing.size());
+    timings.correct = timings.correct && falseHits == 0;
+
+    size_t visited = 0;
+    start = high_resolution_clock::now();
+    for (const auto& entry : map) {
+        checksum += entry.second;
+        visited++;
+    }
+    stop = high_resolution_clock::now();
+    timings.iterate = perOp(start, stop, map.size());
+    timings.correct = timings.correct && visited == map.size();
+
+    size_t erased = 0;
+    start = high_resolution_clock::now();
+    for (int key : lookups) erased += map.erase(key);
+    stop = high_resolution_clock::now();
+    timings.erase = perOp(start, stop, lookups.size());
+    timings.correct = timings.correct && erased == keys.size() && map.empty();
+    return timings;
+}
+
+void prepare(FlatHashMap<int, int>& map, size_t capacity){
+    // the max load factor only has to allow the target load, the table size is fixed by rehash
+    map.max_load_factor(0.95f);
+    map.rehash(capacity);
+}
+
+void prepare(std::unordered_map<int, int>& map, size_t keys){
+    map.reserve(keys);
+}
+
+double perOp(high_resolution_clock::time_point start, high_resolution_clock::time_point stop, size_t ops){
+    return ops == 0 ? 0 : (double)duration_cast<nanoseconds>(stop - start).count() / ops;
+}
@@ -0,0 +1,184 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "../MPMCQueue.h"
+
+using std::cout, std::vector, std::string;
+using std::chrono::steady_clock, std::chrono::duration_cast, std::chrono::nanoseconds;
+
+// throughput and latency of MPMCQueue and SPSCQueue against a std::queue guarded by a std::mutex,
+// for several producer/consumer counts. every producer pushes `items` / producers items stamped with
+// the time of the push, the consumers record how long each item waited in the queue. the last
+// producer to finish pushes one stop item per consumer. all three queues are used through the
+// same non-blocking try_push/try_pop loop. results (median run of `reps` by throughput) are appended
+// to timingsQueue.csv.
+// usage: ./a.out [items]
+
+struct Item {
+    uint64_t value;
+    uint64_t pushedNs;
+};
+
+class MutexQueue {
+    // the baseline: one lock around a std::queue, bounded like the ring queues
+    std::queue<Item> items;
+    std::mutex mutex;
+    size_t limit;
+
+    public:
+        explicit MutexQueue(size_t capacity) : limit(capacity) {}
+
+        bool try_push(const Item& item){
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.size() >= limit) return false;
+            items.push(item);
+            return true;
+        }
+
+        bool try_pop(Item& out){
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.empty()) return false;
+            out = items.front();
+            items.pop();
+            return true;
+        }
+};
+
+struct RunResult {
+    double mopsPerSec = 0;
+    double p50LatencyNs = 0;
+    double p99LatencyNs = 0;
+    bool correct = true;
+};
+
+template <typename Queue> RunResult runQueue(int producers, int consumers, uint64_t items);
+uint64_t nowNs();
+
+const uint64_t stopValue = UINT64_MAX;
+const size_t queueSize = 1024;
+vector<std::pair<int, int>> threadCounts = {{1, 1}, {2, 2}, {4, 4}, {1, 4}, {4, 1}};
+int reps = 3;
+
+int main(int argc, char* argv[]){
+    uint64_t items = argc > 1 ? atoll(argv[1]) : 1000000;
+    std::ofstream file;
+    file.open("timingsQueue.csv", std::ios::app);
+    if (!file.is_open()) {
+        cout << "Error opening timingsQueue.csv for writing.\n";
+        return 1;
+    }
+    file << "queue,producers,consumers,items,mopsPerSec,p50LatencyNs,p99LatencyNs\n";
+    bool allCorrect = true;
+    for (auto [producers, consumers] : threadCounts) {
+        vector<string> queues = {"mpmc", "mutex"};
+        if (producers == 1 && consumers == 1) queues.insert(queues.begin(), "spsc");
+        for (const string& queue : queues) {
+            vector<RunResult> runs;
+            for (int rep = 0; rep < reps; rep++) {
+                if (queue == "spsc") runs.push_back(runQueue<SPSCQueue<Item>>(producers, consumers, items));
+                else if (queue == "mpmc") runs.push_back(runQueue<MPMCQueue<Item>>(producers, consumers, items));
+                else runs.push_back(runQueue<MutexQueue>(producers, consumers, items));
+                allCorrect = allCorrect && runs.back().correct;
+            }
+            std::sort(runs.begin(), runs.end(), [](const RunResult& a, const RunResult& b){
+                return a.mopsPerSec < b.mopsPerSec;
+            });
+            RunResult run = runs[reps/2];
+            file << queue << "," << producers << "," << consumers << "," << items << "," << run.mopsPerSec << ","
+                 << run.p50LatencyNs << "," << run.p99LatencyNs << "\n";
+            cout << queue << " " << producers << "p/" << consumers << "c: " << run.mopsPerSec << " Mops/s, latency p50 "
+                 << run.p50LatencyNs << " ns, p99 " << run.p99LatencyNs << " ns\n";
+        }
+    }
+    file.close();
+    if (!allCorrect) {
+        cout << "Some items were lost or duplicated.\n";
+        return 1;
+    }
+    cout << "All queue operations completed.\n";
+    return 0;
+}
+
+template <typename Queue>
+RunResult runQueue(int producers, int consumers, uint64_t items){
+    Queue queue(queueSize);
+    vector<vector<uint64_t>> latencies(consumers);
+    vector<uint64_t> sums(consumers, 0);
+    uint64_t perProducer = items / producers;
+    std::atomic<bool> start{false};
+    std::atomic<int> producersDone{0};
+
+    vector<std::thread> consumerThreads;
+    for (int c = 0; c < consumers; c++) {
+        consumerThreads.emplace_back([&, c](){
+            latencies[c].reserve(items / consumers + 1);
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+            Item item;
+            int spins = 0;
+            while (true) {
+                if (!queue.try_pop(item)) {
+                    queueBackoff(spins);
+                    continue;
+                }
+                spins = 0;
+                if (item.value == stopValue) break;
+                latencies[c].push_back(nowNs() - item.pushedNs);
+                sums[c] += item.value;
+            }
+        });
+    }
+    vector<std::thread> producerThreads;
+    for (int p = 0; p < producers; p++) {
+        producerThreads.emplace_back([&, p](){
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+            int spins = 0;
+            for (uint64_t i = p * perProducer; i < (p + 1) * perProducer; i++) {
+                while (!queue.try_push(Item{i, nowNs()})) queueBackoff(spins);
+                spins = 0;
+            }
+            // the last producer to finish stops the consumers, so the spsc queue keeps one producer
+            if (producersDone.fetch_add(1) + 1 == producers) {
+                for (int c = 0; c < consumers; c++) {
+                    while (!queue.try_push(Item{stopValue, 0})) queueBackoff(spins);
+                }
+            }
+        });
+    }
+
+    auto startTime = steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& thread : producerThreads) thread.join();
+    for (auto& thread : consumerThreads) thread.join();
+    auto stopTime = steady_clock::now();
+
+    RunResult result;
+    uint64_t total = perProducer * producers;
+    result.mopsPerSec = total / (duration_cast<nanoseconds>(stopTime - startTime).count() / 1e3);
+
+    // every value 0..total-1 exactly once
+    uint64_t sum = 0;
+    vector<uint64_t> all;
+    for (int c = 0; c < consumers; c++) {
+        sum += sums[c];
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    }
+    result.correct = all.size() == total && sum == total * (total - 1) / 2;
+    if (!all.empty()) {
+        std::nth_element(all.begin(), all.begin() + all.size()/2, all.end());
+        result.p50LatencyNs = all[all.size()/2];
+        std::nth_element(all.begin(), all.begin() + all.size()*99/100, all.end());
+        result.p99LatencyNs = all[all.size()*99/100];
+    }
+    return result;
+}
+
+uint64_t nowNs(){
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
@@ -4,7 +4,12 @@
 #include <unordered_map>
 #include <string>
 #include <list>
+#include <vector>
+#include <thread>
+#include <atomic>
 #include "DoublyLinkedList.h"
+#include "FlatHashMap.h"
+#include "MPMCQueue.h"
 
 void testQueue(){
     std::queue<int> q;
@@ -18,6 +23,30 @@ void testQueue(){
     }
 }
 
+void testMPMCQueue(){
+    // bounded, thread safe version of testQueue: 2 producers and 2 consumers share one queue
+    // (benchmark against a mutex guarded std::queue in queue-benchmark/main.cpp)
+    MPMCQueue<int> q(8);
+    std::vector<std::thread> threads;
+    std::atomic<int> sum{0};
+    for (int p=0; p<2; p++){
+        threads.emplace_back([&q](){
+            for (int i=0; i<10; i++) q.push(i);
+        });
+    }
+    for (int c=0; c<2; c++){
+        threads.emplace_back([&q, &sum](){
+            int res;
+            for (int i=0; i<10; i++){
+                q.pop(res);
+                sum += res;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    std::cout << "sum of everything popped: " << sum << std::endl;
+}
+
 void testStack(){
     std::stack<int> s;
      for(int i=0; i<10; i++){
@@ -39,6 +68,21 @@ void testUnorderedMap(){
     return;
 }
 
+void testFlatHashMap(){
+    // same as above but open addressing, all entries sit in one array instead of one node each
+    // (benchmark against unordered_map in hashmap-benchmark/main.cpp)
+    FlatHashMap<int,std::string> map;
+    map[1] = "one";
+    map[3] = "three";
+    map.insert({5, "five"});
+    map.erase(3);
+    std::cout << map[1] << std::endl << map.count(3) << std::endl << map.at(5) << std::endl;
+    for (auto& entry : map){
+        std::cout << entry.first << ": " << entry.second << std::endl;
+    }
+    return;
+}
+
 void testDoublyLinkedList(){
     DoublyLinkedList list = DoublyLinkedList();
     for (int i=0; i<10; i++){
@@ -57,6 +101,8 @@ void testDoublyLinkedList(){
 
 int main(){
     // testUnorderedMap();
+    // testFlatHashMap();
+    // testMPMCQueue();
     // std::cout << __cplusplus / 100 % 100 << '\n';
     // std::cout << list.isEmpty() << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,388 @@
+#ifndef SORTENGINES_H
+#define SORTENGINES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "../sorting-networks/SortingNetworks.h"
+#include "SortTrace.h"
+
+// pointer based versions of the sort engines for any arithmetic element type (int32_t, int64_t,
+// float, ...). unlike the vector<int> experiments they sort in place, so they also work on memory
+// that is not owned by a vector, e.g. a mmap'd file. hybrid, merge, radix and runs need a scratch
+// buffer of n elements, quick and quick3 sort without one. float NaNs only get a defined position
+// with radix.
+
+enum class Engine { Hybrid, Merge, Quick, Radix, Runs, Quick3 };
+
+const size_t hybridLeafSize = 32;  // leaves up to this size use a sorting network
+const size_t quickCutoff = 16;     // quicksort leaves ranges this small to insertion sort
+const size_t minRunLength = 32;    // run-adaptive merge extends shorter natural runs with insertion sort
+
+inline bool parseEngine(const std::string& name, Engine& engine){
+    if (name == "hybrid") engine = Engine::Hybrid;
+    else if (name == "merge") engine = Engine::Merge;
+    else if (name == "quick") engine = Engine::Quick;
+    else if (name == "radix") engine = Engine::Radix;
+    else if (name == "runs") engine = Engine::Runs;
+    else if (name == "quick3") engine = Engine::Quick3;
+    else return false;
+    return true;
+}
+
+inline const char* engineName(Engine engine){
+    switch (engine){
+        case Engine::Hybrid: return "hybrid";
+        case Engine::Merge: return "merge";
+        case Engine::Quick: return "quick";
+        case Engine::Radix: return "radix";
+        case Engine::Runs: return "runs";
+        case Engine::Quick3: return "quick3";
+    }
+    return "?";
+}
+
+template <typename T>
+void insertionSortRange(T* arr, size_t n){
+    for (size_t i=1; i<n; i++){
+        T value = arr[i];
+        size_t j = i;
+        while (j > 0 && value < arr[j-1]){
+            arr[j] = arr[j-1];
+            j--;
+        }
+        arr[j] = value;
+    }
+}
+
+template <typename T>
+size_t mergeRuns(const T* left, size_t leftLen, const T* right, size_t rightLen, T* out){
+    // stable: on equal keys the left run goes first. returns the number of key comparisons
+    size_t x = 0;
+    size_t y = 0;
+    while (x < leftLen && y < rightLen){
+        // branch free, interleaved runs would mispredict about every other element otherwise
+        bool takeRight = right[y] < left[x];
+        *out++ = takeRight ? right[y] : left[x];
+        y += takeRight;
+        x += !takeRight;
+    }
+    std::memcpy(out, left + x, (leftLen - x)*sizeof(T));
+    out += leftLen - x;
+    std::memcpy(out, right + y, (rightLen - y)*sizeof(T));
+    return x + y;
+}
+
+template <bool Traced, typename T>
+void mergeSortPingPong(T* src, T* dst, size_t n, size_t leafSize, bool intoDst, int depth = 0){
+    // sorts src[0..n), the result ends up in dst when intoDst is set, otherwise back in src.
+    // each level merges from one array into the other, so there is no copy back per level
+    using Scope = TraceScopeIf<Traced>;
+    Scope node(TracePhase::Node, depth, n);
+    if (n <= leafSize){
+        Scope leaf(TracePhase::Leaf, depth, n);
+        if (n <= maxNetworkSize){
+            sort_small(src, (int)n);
+            if (Traced) leaf.addComparisons(network_size((int)n));
+        }
+        else insertionSortRange(src, n);
+        if (intoDst) std::memcpy(dst, src, n*sizeof(T));
+        return;
+    }
+    size_t half = n/2;
+    mergeSortPingPong<Traced>(src, dst, half, leafSize, !intoDst, depth + 1);
+    mergeSortPingPong<Traced>(src + half, dst + half, n - half, leafSize, !intoDst, depth + 1);
+    Scope merge(TracePhase::Merge, depth, n);
+    if (intoDst) merge.addComparisons(mergeRuns(src, half, src + half, n - half, dst));
+    else merge.addComparisons(mergeRuns(dst, half, dst + half, n - half, src));
+}
+
+template <bool Traced, typename T>
+void hybridSortRange(T* arr, T* buf, size_t n, int depth = 0){
+    mergeSortPingPong<Traced>(arr, buf, n, hybridLeafSize, false, depth);
+}
+
+template <bool Traced, typename T>
+void mergeSortRange(T* arr, T* buf, size_t n, int depth = 0){
+    mergeSortPingPong<Traced>(arr, buf, n, 1, false, depth);
+}
+
+template <typename T>
+void quickSortRange(T* arr, size_t n, int depthLimit){
+    // median of three + Hoare partition, falls back to heap sort when the recursion gets too deep
+    while (n > quickCutoff){
+        if (depthLimit-- == 0){
+            std::make_heap(arr, arr + n);
+            std::sort_heap(arr, arr + n);
+            return;
+        }
+        size_t mid = n/2;
+        if (arr[mid] < arr[0]) std::swap(arr[mid], arr[0]);
+        if (arr[n-1] < arr[0]) std::swap(arr[n-1], arr[0]);
+        if (arr[n-1] < arr[mid]) std::swap(arr[n-1], arr[mid]);
+        T pivot = arr[mid];
+        size_t i = 0;
+        size_t j = n - 1;
+        while (true){
+            while (arr[i] < pivot) i++;
+            while (pivot < arr[j]) j--;
+            if (i >= j) break;
+            std::swap(arr[i++], arr[j--]);
+        }
+        // recurse into the smaller side, loop on the bigger one
+        size_t leftLen = j + 1;
+        if (leftLen < n - leftLen){
+            quickSortRange(arr, leftLen, depthLimit);
+            arr += leftLen;
+            n -= leftLen;
+        }
+        else {
+            quickSortRange(arr + leftLen, n - leftLen, depthLimit);
+            n = leftLen;
+        }
+    }
+    insertionSortRange(arr, n);
+}
+
+template <typename T>
+void quickSortRange(T* arr, size_t n){
+    int depthLimit = 0;
+    for (size_t m=n; m>1; m/=2){
+        depthLimit += 2;
+    }
+    quickSortRange(arr, n, depthLimit);
+}
+
+template <typename T>
+struct RadixKey {
+    // maps T onto an unsigned integer with the same ordering
+    using Bits = std::conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+    static Bits get(T value){
+        Bits bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        const Bits signBit = Bits(1) << (sizeof(T)*8 - 1);
+        if (std::is_floating_point<T>::value){
+            // negative floats sort in reverse bit order, so flip all their bits
+            return (bits & signBit) ? ~bits : bits | signBit;
+        }
+        if (std::is_signed<T>::value){
+            return bits ^ signBit;
+        }
+        return bits;
+    }
+};
+
+template <typename T>
+void radixSortRange(T* arr, T* buf, size_t n){
+    // LSD radix sort on 8 bit digits, digits where every element falls in one bucket are skipped
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "radix sort handles 32 and 64 bit keys");
+    // keys are taken relative to the smallest one, so a narrow range only needs its low digits
+    const int passes = sizeof(T);
+    auto minKey = RadixKey<T>::get(arr[0]);
+    for (size_t i=1; i<n; i++){
+        minKey = std::min(minKey, RadixKey<T>::get(arr[i]));
+    }
+    std::vector<size_t> counts(passes*256, 0);
+    for (size_t i=0; i<n; i++){
+        auto key = RadixKey<T>::get(arr[i]) - minKey;
+        for (int p=0; p<passes; p++){
+            counts[p*256 + ((key >> (8*p)) & 0xff)]++;
+        }
+    }
+    T* src = arr;
+    T* dst = buf;
+    for (int p=0; p<passes; p++){
+        size_t* count = counts.data() + p*256;
+        if (count[((RadixKey<T>::get(src[0]) - minKey) >> (8*p)) & 0xff] == n) continue;
+        size_t offset = 0;
+        for (int d=0; d<256; d++){
+            size_t c = count[d];
+            count[d] = offset;
+            offset += c;
+        }
+        for (size_t i=0; i<n; i++){
+            dst[count[((RadixKey<T>::get(src[i]) - minKey) >> (8*p)) & 0xff]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+    if (src != arr) std::memcpy(arr, src, n*sizeof(T));
+}
+
+template <typename T>
+void runMergeSortRange(T* arr, T* buf, size_t n){
+    // natural merge sort: existing ascending runs (and strictly descending ones, reversed) are kept,
+    // runs shorter than minRunLength are extended with insertion sort, then neighbouring runs are
+    // merged pairwise. nearly sorted input ends up as a handful of long runs and few merges
+    std::vector<size_t> runStarts;
+    size_t start = 0;
+    while (start < n){
+        size_t end = start + 1;
+        if (end < n && arr[end] < arr[start]){
+            while (end < n && arr[end] < arr[end-1]) end++;
+            std::reverse(arr + start, arr + end);
+        }
+        else {
+            while (end < n && !(arr[end] < arr[end-1])) end++;
+        }
+        if (end - start < minRunLength){
+            end = std::min(start + minRunLength, n);
+            insertionSortRange(arr + start, end - start);
+        }
+        runStarts.push_back(start);
+        start = end;
+    }
+    runStarts.push_back(n);
+
+    T* src = arr;
+    T* dst = buf;
+    while (runStarts.size() > 2){
+        std::vector<size_t> merged;
+        size_t r = 0;
+        for (; r + 2 < runStarts.size(); r += 2){
+            size_t lo = runStarts[r];
+            size_t mid = runStarts[r+1];
+            size_t hi = runStarts[r+2];
+            mergeRuns(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+            merged.push_back(lo);
+        }
+        if (r + 1 < runStarts.size()){
+            // odd run out, carried over as is
+            size_t lo = runStarts[r];
+            std::memcpy(dst + lo, src + lo, (n - lo)*sizeof(T));
+            merged.push_back(lo);
+        }
+        merged.push_back(n);
+        runStarts.swap(merged);
+        std::swap(src, dst);
+    }
+    if (src != arr) std::memcpy(arr, src, n*sizeof(T));
+}
+
+template <typename T>
+void quickSort3Range(T* arr, size_t n, int depthLimit){
+    // quicksort with a three way (Dijkstra) partition: keys equal to the pivot are gathered in the
+    // middle and never touched again, so inputs with few distinct keys finish in a few passes
+    while (n > quickCutoff){
+        if (depthLimit-- == 0){
+            std::make_heap(arr, arr + n);
+            std::sort_heap(arr, arr + n);
+            return;
+        }
+        size_t mid = n/2;
+        if (arr[mid] < arr[0]) std::swap(arr[mid], arr[0]);
+        if (arr[n-1] < arr[0]) std::swap(arr[n-1], arr[0]);
+        if (arr[n-1] < arr[mid]) std::swap(arr[n-1], arr[mid]);
+        T pivot = arr[mid];
+        // [0, lt) < pivot, [lt, i) == pivot, (gt, n) > pivot
+        size_t lt = 0;
+        size_t i = 0;
+        size_t gt = n;
+        while (i < gt){
+            if (arr[i] < pivot) std::swap(arr[lt++], arr[i++]);
+            else if (pivot < arr[i]) std::swap(arr[i], arr[--gt]);
+            else i++;
+        }
+        size_t rightLen = n - gt;
+        if (lt < rightLen){
+            quickSort3Range(arr, lt, depthLimit);
+            arr += gt;
+            n = rightLen;
+        }
+        else {
+            quickSort3Range(arr + gt, rightLen, depthLimit);
+            n = lt;
+        }
+    }
+    insertionSortRange(arr, n);
+}
+
+template <typename T>
+void quickSort3Range(T* arr, size_t n){
+    int depthLimit = 0;
+    for (size_t m=n; m>1; m/=2){
+        depthLimit += 2;
+    }
+    quickSort3Range(arr, n, depthLimit);
+}
+
+template <typename T>
+void sortRange(T* arr, T* buf, size_t n, Engine engine, int depth = 0){
+    // depth is where this range sits in the trace, sortArray passes the number of merge rounds
+    // above its chunks. only hybrid and merge are traced per recursion node, the other engines
+    // show up as a single leaf span. the flag is read once here, the recursions below are
+    // instantiated with and without their trace scopes
+    if (n < 2) return;
+    bool traced = sortTraceEnabled;
+    switch (engine){
+        case Engine::Hybrid:
+            if (traced) hybridSortRange<true>(arr, buf, n, depth);
+            else hybridSortRange<false>(arr, buf, n, depth);
+            return;
+        case Engine::Merge:
+            if (traced) mergeSortRange<true>(arr, buf, n, depth);
+            else mergeSortRange<false>(arr, buf, n, depth);
+            return;
+        default: break;
+    }
+    TraceScope leaf(TracePhase::Leaf, depth, n);
+    switch (engine){
+        case Engine::Quick: quickSortRange(arr, n); break;
+        case Engine::Radix: radixSortRange(arr, buf, n); break;
+        case Engine::Runs: runMergeSortRange(arr, buf, n); break;
+        case Engine::Quick3: quickSort3Range(arr, n); break;
+        default: break;
+    }
+}
+
+template <typename T>
+void sortArray(T* arr, size_t n, Engine engine, int threads){
+    // sorts arr[0..n) in place. with more than one thread the array is cut into one chunk per
+    // thread, the chunks are sorted concurrently and then merged pairwise, pairs in parallel
+    std::vector<T> buffer;
+    bool needsBuffer = engine != Engine::Quick && engine != Engine::Quick3;
+    if (needsBuffer || threads > 1) buffer.resize(n);
+    T* buf = buffer.data();
+
+    if (threads <= 1 || n < 2*(size_t)threads){
+        sortRange(arr, buf, n, engine);
+        return;
+    }
+
+    size_t chunk = (n + threads - 1)/threads;
+    // the merge rounds form the top of the recursion tree in a trace, the chunks sit below them
+    int rounds = 0;
+    for (size_t width=chunk; width<n; width*=2) rounds++;
+
+    std::vector<std::thread> workers;
+    for (size_t start=0; start<n; start+=chunk){
+        size_t len = std::min(chunk, n - start);
+        workers.emplace_back([=](){ sortRange(arr + start, buf + start, len, engine, rounds); });
+    }
+    for (auto& worker : workers) worker.join();
+
+    T* src = arr;
+    T* dst = buf;
+    int depth = rounds;
+    for (size_t width=chunk; width<n; width*=2){
+        workers.clear();
+        depth--;
+        for (size_t start=0; start<n; start+=2*width){
+            size_t mid = std::min(start + width, n);
+            size_t end = std::min(start + 2*width, n);
+            workers.emplace_back([=](){
+                TraceScope merge(TracePhase::Merge, depth, end - start);
+                merge.addComparisons(mergeRuns(src + start, mid - start, src + mid, end - mid, dst + start));
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        std::swap(src, dst);
+    }
+    if (src != arr) std::memcpy(arr, src, n*sizeof(T));
+}
+
+#endif // SORTENGINES_H
@@ -0,0 +1,157 @@
+#ifndef SORTPLANNER_H
+#define SORTPLANNER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "SortEngines.h"
+
+// picks an engine per call from a small sample of the input instead of making the caller choose.
+// the sample looks at (all O(sample size), independent of n):
+//   - the direction (up/down) of evenly spaced adjacent pairs; how often it changes estimates the
+//     number of runs, so sorted, reversed, organ pipe and k-run inputs all show few changes
+//   - inversions between random pairs of positions (0 = sorted, 0.5 = random, 1 = reversed)
+//   - smallest and largest sampled key, for the key range of integer inputs
+//   - distinct keys in the sample, for the duplicate ratio
+// and the plan is then
+//   tiny input                                  -> hybrid (network/insertion leaves, no setup cost)
+//   few runs                                    -> runs (natural merge sort)
+//   mostly sorted but many short runs           -> quick (median of three copes well with it)
+//   integers with a narrow range                -> radix (only the low digits get a pass)
+//   lots of duplicates, radix would be costly   -> quick3 (three way partitioning)
+//   large input                                 -> radix
+//   anything else                               -> quick
+// radix counts as costly below plannerRadixInput elements or when the sampled range needs more
+// than 4 digit passes (wide 64 bit keys).
+
+const size_t plannerRunSamples = 1024;         // adjacent pairs looked at for the run estimate
+const size_t plannerKeySamples = 256;          // random positions for inversions, range and duplicates
+const size_t plannerSmallInput = 256;         // below this just sort, sampling would cost more than it saves
+const double plannerRunChanges = 0.01;        // direction changes per sampled pair under which there are few runs
+const double plannerMostlySorted = 0.05;      // inversion ratio (or 1 - ratio) under which the input is mostly in order
+const double plannerDuplicateRatio = 0.5;     // share of repeated keys in the sample that means "heavy duplicates"
+const double plannerNarrowRange = 65536;      // integer key range that radix covers in two passes
+const size_t plannerRadixInput = 4096;        // inputs this big go to radix even with a wide range
+
+struct SortPlan {
+    Engine engine = Engine::Hybrid;
+    const char* reason = "";
+    size_t n = 0;
+    double runChangeRatio = 0;
+    double inversionRatio = 0;
+    double duplicateRatio = 0;
+    double minKey = 0;
+    double maxKey = 0;
+    double samplingNs = 0;
+};
+
+inline bool plannerLog = false; // print every decision to stderr
+
+inline uint64_t plannerRandom(uint64_t& state){
+    // xorshift, only needs to be cheap and spread positions around
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+template <typename T>
+SortPlan planSort(const T* arr, size_t n){
+    auto start = std::chrono::high_resolution_clock::now();
+    SortPlan plan;
+    plan.n = n;
+
+    if (n < plannerSmallInput){
+        plan.engine = Engine::Hybrid;
+        plan.reason = "small input";
+    }
+    else {
+        size_t samples = std::min(plannerRunSamples, n/8);
+        size_t stride = (n - 1) / samples;
+        size_t changes = 0;
+        int lastDirection = 0;
+        for (size_t s=0; s<samples; s++){
+            size_t i = s*stride;
+            // equal neighbours continue whatever run they are in
+            int direction = arr[i+1] < arr[i] ? -1 : (arr[i] < arr[i+1] ? 1 : 0);
+            if (direction != 0){
+                if (lastDirection != 0 && direction != lastDirection) changes++;
+                lastDirection = direction;
+            }
+        }
+        plan.runChangeRatio = (double)changes / samples;
+
+        samples = std::min(plannerKeySamples, n/8);
+        uint64_t state = 0x9e3779b97f4a7c15ull ^ n;
+        size_t inversions = 0;
+        std::vector<T> keys;
+        keys.reserve(samples);
+        for (size_t s=0; s<samples; s++){
+            size_t i = plannerRandom(state) % n;
+            size_t j = plannerRandom(state) % n;
+            if (i > j) std::swap(i, j);
+            if (i != j && arr[j] < arr[i]) inversions++;
+            keys.push_back(arr[i]);
+        }
+        plan.inversionRatio = (double)inversions / samples;
+
+        std::sort(keys.begin(), keys.end());
+        size_t distinct = std::unique(keys.begin(), keys.end()) - keys.begin();
+        plan.duplicateRatio = 1.0 - (double)distinct / samples;
+        plan.minKey = (double)keys.front();
+        plan.maxKey = (double)keys[distinct - 1];
+
+        bool integral = std::is_integral<T>::value;
+        int radixPasses = sizeof(T);
+        if (integral){
+            radixPasses = 1;
+            for (double range = plan.maxKey - plan.minKey; range >= 256; range /= 256) radixPasses++;
+        }
+        if (plan.runChangeRatio <= plannerRunChanges){
+            plan.engine = Engine::Runs;
+            plan.reason = "few runs";
+        }
+        else if (plan.inversionRatio <= plannerMostlySorted || plan.inversionRatio >= 1 - plannerMostlySorted){
+            plan.engine = Engine::Quick;
+            plan.reason = "mostly sorted";
+        }
+        else if (integral && plan.maxKey - plan.minKey < plannerNarrowRange){
+            plan.engine = Engine::Radix;
+            plan.reason = "narrow integer range";
+        }
+        else if (plan.duplicateRatio >= plannerDuplicateRatio && (n < plannerRadixInput || radixPasses > 4)){
+            plan.engine = Engine::Quick3;
+            plan.reason = "heavy duplicates";
+        }
+        else if (n >= plannerRadixInput){
+            plan.engine = Engine::Radix;
+            plan.reason = "large input";
+        }
+        else {
+            plan.engine = Engine::Quick;
+            plan.reason = "general input";
+        }
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    plan.samplingNs = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    if (plannerLog){
+        std::cerr << "planner: n=" << n << " run changes=" << plan.runChangeRatio << " inversions=" << plan.inversionRatio
+                  << " duplicates=" << plan.duplicateRatio << " range=[" << plan.minKey << ", " << plan.maxKey << "]"
+                  << " -> " << engineName(plan.engine) << " (" << plan.reason << "), sampling took "
+                  << plan.samplingNs/1000 << " us\n";
+    }
+    return plan;
+}
+
+template <typename T>
+SortPlan plannedSort(T* arr, size_t n, int threads = 1){
+    SortPlan plan = planSort(arr, n);
+    sortArray(arr, n, plan.engine, threads);
+    return plan;
+}
+
+#endif // SORTPLANNER_H
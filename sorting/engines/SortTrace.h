@@ -0,0 +1,224 @@
+#ifndef SORTTRACE_H
+#define SORTTRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// optional recursion tracing for the sort engines. while sortTraceEnabled is set, every TraceScope
+// records one span (start, end, depth, range size, phase, comparisons) into a ring buffer owned by
+// the calling thread, so recording never takes a lock. when a ring is full the oldest spans are
+// overwritten, but each thread also keeps running per depth/phase totals, so the summary table
+// stays exact. afterwards (once worker threads are joined) the spans can be written as a Chrome
+// trace (chrome://tracing or ui.perfetto.dev) and the totals printed per depth.
+//
+// phases: node = a whole recursion node (includes its children, only shown in the trace),
+// split = dividing the range (copies/allocations or partitioning), leaf = small range sorted
+// directly, merge = joining two sorted halves.
+
+enum class TracePhase : uint8_t { Node, Split, Leaf, Merge };
+
+const int traceMaxDepth = 64;
+const int tracePhaseCount = 4;
+
+inline bool sortTraceEnabled = false;
+inline size_t traceRingCapacity = 1 << 16; // spans kept per thread
+
+struct TraceSpan {
+    uint64_t start;
+    uint64_t end;
+    uint64_t comparisons;
+    uint32_t size;
+    uint16_t depth;
+    TracePhase phase;
+};
+
+struct TraceTotals {
+    uint64_t spans = 0;
+    uint64_t ns = 0;
+    uint64_t comparisons = 0;
+};
+
+struct TraceRing {
+    int threadId = 0;
+    std::vector<TraceSpan> spans;
+    size_t next = 0;
+    uint64_t recorded = 0;
+    TraceTotals totals[traceMaxDepth][tracePhaseCount];
+
+    void push(const TraceSpan& span){
+        if (spans.size() < traceRingCapacity) spans.push_back(span);
+        else spans[next] = span;
+        next = (next + 1) % traceRingCapacity;
+        recorded++;
+        int depth = span.depth < traceMaxDepth ? span.depth : traceMaxDepth - 1;
+        TraceTotals& total = totals[depth][(int)span.phase];
+        total.spans++;
+        total.ns += span.end - span.start;
+        total.comparisons += span.comparisons;
+    }
+};
+
+// rings are owned here rather than by the thread, so they outlive the worker threads that filled them
+inline std::mutex traceRegistryMutex;
+inline std::vector<std::unique_ptr<TraceRing>> traceRegistry;
+
+inline TraceRing& threadTraceRing(){
+    thread_local TraceRing* ring = nullptr;
+    if (ring == nullptr){
+        std::lock_guard<std::mutex> lock(traceRegistryMutex);
+        traceRegistry.push_back(std::make_unique<TraceRing>());
+        ring = traceRegistry.back().get();
+        ring->threadId = traceRegistry.size();
+        ring->spans.reserve(traceRingCapacity);
+    }
+    return *ring;
+}
+
+inline uint64_t traceNow(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class TraceScope {
+    // records a span from construction to destruction. comparisons are either added explicitly or,
+    // when a counter is given, taken as how much that counter grew in the meantime
+    bool active;
+    TracePhase phase;
+    uint16_t depth;
+    uint32_t size;
+    const uint64_t* counter;
+    uint64_t counterStart = 0;
+    uint64_t comparisons = 0;
+    uint64_t start = 0;
+
+    public:
+        TraceScope(TracePhase phase, int depth, size_t size, const uint64_t* counter = nullptr)
+            : active(sortTraceEnabled), phase(phase), depth(depth), size(size), counter(counter){
+            if (!active) return;
+            if (counter != nullptr) counterStart = *counter;
+            start = traceNow();
+        }
+
+        void addComparisons(uint64_t count){
+            comparisons += count;
+        }
+
+        ~TraceScope(){
+            if (!active) return;
+            uint64_t end = traceNow();
+            if (counter != nullptr) comparisons += *counter - counterStart;
+            threadTraceRing().push({start, end, comparisons, size, depth, phase});
+        }
+};
+
+class NoTraceScope {
+    // stands in for TraceScope in recursions instantiated without tracing, compiles to nothing
+    public:
+        NoTraceScope(TracePhase, int, size_t, const uint64_t* = nullptr){}
+        void addComparisons(uint64_t){}
+};
+
+// recursions take a bool Traced template parameter and pick their scope type with this, so the
+// untraced instantiation does not even check sortTraceEnabled per node
+template <bool Traced>
+using TraceScopeIf = std::conditional_t<Traced, TraceScope, NoTraceScope>;
+
+inline const char* tracePhaseName(TracePhase phase){
+    switch (phase){
+        case TracePhase::Node: return "node";
+        case TracePhase::Split: return "split";
+        case TracePhase::Leaf: return "leaf";
+        case TracePhase::Merge: return "merge";
+    }
+    return "?";
+}
+
+inline void traceReset(){
+    // only call while no sort is running
+    std::lock_guard<std::mutex> lock(traceRegistryMutex);
+    for (auto& ring : traceRegistry){
+        int threadId = ring->threadId;
+        *ring = TraceRing();
+        ring->threadId = threadId;
+        ring->spans.reserve(traceRingCapacity);
+    }
+}
+
+inline bool writeChromeTrace(const std::string& path, const std::string& name){
+    // complete ("X") events, timestamps in microseconds relative to the first recorded span
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+    std::lock_guard<std::mutex> lock(traceRegistryMutex);
+    uint64_t origin = UINT64_MAX;
+    for (auto& ring : traceRegistry){
+        for (const TraceSpan& span : ring->spans){
+            if (span.start < origin) origin = span.start;
+        }
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    for (auto& ring : traceRegistry){
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"sort thread %d\"}}",
+                first ? "" : ",", ring->threadId, ring->threadId);
+        first = false;
+        for (const TraceSpan& span : ring->spans){
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                          "\"args\":{\"depth\":%u,\"size\":%u,\"comparisons\":%llu}}",
+                    tracePhaseName(span.phase), name.c_str(), ring->threadId, (span.start - origin)/1000.0,
+                    (span.end - span.start)/1000.0, (unsigned)span.depth, (unsigned)span.size,
+                    (unsigned long long)span.comparisons);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+inline void printTraceSummary(std::ostream& out){
+    // time and comparisons spent in each phase per recursion depth, summed over all threads.
+    // node spans are left out since they include their children
+    TraceTotals totals[traceMaxDepth][tracePhaseCount];
+    uint64_t recorded = 0;
+    uint64_t kept = 0;
+    std::lock_guard<std::mutex> lock(traceRegistryMutex);
+    for (auto& ring : traceRegistry){
+        recorded += ring->recorded;
+        kept += ring->spans.size();
+        for (int d=0; d<traceMaxDepth; d++){
+            for (int p=0; p<tracePhaseCount; p++){
+                totals[d][p].spans += ring->totals[d][p].spans;
+                totals[d][p].ns += ring->totals[d][p].ns;
+                totals[d][p].comparisons += ring->totals[d][p].comparisons;
+            }
+        }
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-6s %-9s %-12s %-12s %-12s %-14s\n", "depth", "nodes", "split ms", "leaf ms", "merge ms", "comparisons");
+    out << line;
+    for (int d=0; d<traceMaxDepth; d++){
+        TraceTotals* row = totals[d];
+        // the parallel merge rounds of sortArray have no node spans, count their merges instead
+        uint64_t nodes = row[(int)TracePhase::Node].spans;
+        if (nodes == 0) nodes = row[(int)TracePhase::Leaf].spans + row[(int)TracePhase::Merge].spans;
+        uint64_t comparisons = row[(int)TracePhase::Split].comparisons + row[(int)TracePhase::Leaf].comparisons
+                             + row[(int)TracePhase::Merge].comparisons;
+        if (nodes == 0) continue;
+        snprintf(line, sizeof(line), "%-6d %-9llu %-12.3f %-12.3f %-12.3f %-14llu\n", d, (unsigned long long)nodes,
+                 row[(int)TracePhase::Split].ns/1e6, row[(int)TracePhase::Leaf].ns/1e6,
+                 row[(int)TracePhase::Merge].ns/1e6, (unsigned long long)comparisons);
+        out << line;
+    }
+    if (kept < recorded){
+        out << "(" << recorded - kept << " of " << recorded << " spans were overwritten in the trace rings, totals above are complete)\n";
+    }
+}
+
+#endif // SORTTRACE_H
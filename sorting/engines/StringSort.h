@@ -0,0 +1,364 @@
+#ifndef STRINGSORT_H
+#define STRINGSORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// sort engines for strings. the strings live back to back in one arena of bytes and each one is
+// described by a slot (offset + length); sorting only permutes the slots, the bytes never move.
+// strings compare byte-wise as unsigned char, the same order as std::string's operator<.
+//
+// comparison sorts re-scan the common prefix of two strings at every comparison, which is most of
+// the work for URLs or identifiers that share long prefixes. these engines avoid that:
+//   multikey: multikey (3 way radix) quicksort, partitions on one character at a time
+//   msd:      MSD radix sort, distributes on one character at a time into 256 buckets
+//   lcpmerge: merge sort that carries the longest common prefix (LCP) of neighbouring strings, so
+//             a merge step only compares the characters after the prefix the two strings are already
+//             known to share
+// all of them sort buckets below stringInsertionCutoff with insertion sort, starting at the
+// character depth the bucket is known to share, like hybridSort does with its small subarrays.
+// with more than one thread the chunks are sorted in parallel and merged with the LCP merge.
+
+enum class StringEngine { Multikey, Msd, LcpMerge };
+
+const size_t stringInsertionCutoff = 32;
+
+inline bool parseStringEngine(const std::string& name, StringEngine& engine){
+    if (name == "multikey") engine = StringEngine::Multikey;
+    else if (name == "msd") engine = StringEngine::Msd;
+    else if (name == "lcpmerge") engine = StringEngine::LcpMerge;
+    else return false;
+    return true;
+}
+
+inline const char* stringEngineName(StringEngine engine){
+    switch (engine){
+        case StringEngine::Multikey: return "multikey";
+        case StringEngine::Msd: return "msd";
+        case StringEngine::LcpMerge: return "lcpmerge";
+    }
+    return "?";
+}
+
+struct StringSlot {
+    uint64_t offset;
+    uint32_t length;
+};
+
+struct StringArena {
+    std::vector<unsigned char> bytes;
+    std::vector<StringSlot> slots;
+
+    void reserve(size_t strings, size_t totalBytes){
+        slots.reserve(strings);
+        bytes.reserve(totalBytes);
+    }
+
+    void add(std::string_view s){
+        slots.push_back({bytes.size(), (uint32_t)s.size()});
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+
+    size_t size() const {
+        return slots.size();
+    }
+
+    std::string_view operator[](size_t i) const {
+        return std::string_view((const char*)bytes.data() + slots[i].offset, slots[i].length);
+    }
+};
+
+inline int charAt(const unsigned char* base, const StringSlot& s, size_t depth){
+    // 0 marks the end of the string, so shorter strings sort first
+    return depth < s.length ? base[s.offset + depth] + 1 : 0;
+}
+
+inline bool lessFrom(const unsigned char* base, const StringSlot& a, const StringSlot& b, size_t depth){
+    // both strings are known to share their first depth characters
+    size_t aLen = a.length - depth;
+    size_t bLen = b.length - depth;
+    size_t common = std::min(aLen, bLen);
+    // memcmp wants valid pointers even for 0 bytes, and base is null when every string is empty
+    int order = common == 0 ? 0 : std::memcmp(base + a.offset + depth, base + b.offset + depth, common);
+    return order < 0 || (order == 0 && aLen < bLen);
+}
+
+inline size_t lcpFrom(const unsigned char* base, const StringSlot& a, const StringSlot& b, size_t depth){
+    // length of the common prefix, given the first depth characters already match
+    size_t limit = std::min(a.length, b.length);
+    const unsigned char* x = base + a.offset;
+    const unsigned char* y = base + b.offset;
+    while (depth < limit && x[depth] == y[depth]) depth++;
+    return depth;
+}
+
+inline size_t commonPrefix(const unsigned char* base, const StringSlot* slots, size_t n, size_t depth){
+    // common prefix of the whole bucket in one pass, so a prefix shared by every string (like
+    // "https://www.") is skipped at once instead of one character per partitioning pass
+    size_t prefix = slots[0].length;
+    for (size_t i=1; i<n && prefix > depth; i++){
+        StringSlot a = slots[0];
+        a.length = prefix;
+        prefix = lcpFrom(base, a, slots[i], depth);
+    }
+    return prefix;
+}
+
+inline void stringInsertionSort(const unsigned char* base, StringSlot* slots, size_t n, size_t depth){
+    for (size_t i=1; i<n; i++){
+        StringSlot key = slots[i];
+        size_t j = i;
+        while (j > 0 && lessFrom(base, key, slots[j-1], depth)){
+            slots[j] = slots[j-1];
+            j--;
+        }
+        slots[j] = key;
+    }
+}
+
+inline void stringLcpArray(const unsigned char* base, const StringSlot* slots, size_t n, uint32_t* lcp){
+    // lcp[i] = common prefix length of slots[i-1] and slots[i], lcp[0] = 0
+    if (n == 0) return;
+    lcp[0] = 0;
+    for (size_t i=1; i<n; i++) lcp[i] = lcpFrom(base, slots[i-1], slots[i], 0);
+}
+
+inline void multikeyQuickSort(const unsigned char* base, StringSlot* slots, size_t n, size_t depth = 0){
+    // Bentley-Sedgewick: 3 way partition on the character at depth. the equal part moves on to the
+    // next character, the smaller and bigger parts stay at this depth. an explicit stack instead of
+    // recursion, long shared prefixes would otherwise recurse once per character
+    struct Job { StringSlot* slots; size_t n; size_t depth; };
+    std::vector<Job> jobs = {{slots, n, depth}};
+    while (!jobs.empty()){
+        Job job = jobs.back();
+        jobs.pop_back();
+        StringSlot* s = job.slots;
+        if (job.n < stringInsertionCutoff){
+            stringInsertionSort(base, s, job.n, job.depth);
+            continue;
+        }
+        // median of three characters as the pivot
+        int a = charAt(base, s[0], job.depth);
+        int b = charAt(base, s[job.n/2], job.depth);
+        int c = charAt(base, s[job.n-1], job.depth);
+        int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+        size_t lt = 0;
+        size_t i = 0;
+        size_t gt = job.n;
+        while (i < gt){
+            int ch = charAt(base, s[i], job.depth);
+            if (ch < pivot) std::swap(s[lt++], s[i++]);
+            else if (ch > pivot) std::swap(s[i], s[--gt]);
+            else i++;
+        }
+        if (lt == 0 && gt == job.n){
+            if (pivot != 0) jobs.push_back({s, job.n, commonPrefix(base, s, job.n, job.depth + 1)});
+            continue;
+        }
+        if (lt > 1) jobs.push_back({s, lt, job.depth});
+        if (job.n - gt > 1) jobs.push_back({s + gt, job.n - gt, job.depth});
+        // strings that ended at this depth are all equal
+        if (pivot != 0 && gt - lt > 1) jobs.push_back({s + lt, gt - lt, job.depth + 1});
+    }
+}
+
+inline void msdRadixSort(const unsigned char* base, StringSlot* slots, size_t n, size_t depth = 0){
+    // distributes on the character at depth into 256 buckets (plus one for strings that ended),
+    // then sorts each bucket on the next character. the characters are read once per level into
+    // an oracle array so the distribution pass does not touch the strings again
+    if (n < 2) return;
+    std::vector<StringSlot> buffer(n);
+    std::vector<uint16_t> oracle(n);
+    struct Job { StringSlot* slots; size_t n; size_t depth; };
+    std::vector<Job> jobs = {{slots, n, depth}};
+    while (!jobs.empty()){
+        Job job = jobs.back();
+        jobs.pop_back();
+        StringSlot* s = job.slots;
+        if (job.n < stringInsertionCutoff){
+            stringInsertionSort(base, s, job.n, job.depth);
+            continue;
+        }
+        size_t count[257] = {};
+        for (size_t i=0; i<job.n; i++){
+            oracle[i] = charAt(base, s[i], job.depth);
+            count[oracle[i]]++;
+        }
+        if (count[0] == job.n) continue;
+        if (count[oracle[0]] == job.n){
+            // everything shares this character, nothing to distribute
+            jobs.push_back({s, job.n, commonPrefix(base, s, job.n, job.depth + 1)});
+            continue;
+        }
+        size_t start[257];
+        size_t sum = 0;
+        for (int c=0; c<257; c++){
+            start[c] = sum;
+            sum += count[c];
+        }
+        for (size_t i=0; i<job.n; i++) buffer[start[oracle[i]]++] = s[i];
+        std::memcpy(s, buffer.data(), job.n*sizeof(StringSlot));
+        // bucket 0 holds the strings that ended, they are all equal
+        size_t bucketStart = count[0];
+        for (int c=1; c<257; c++){
+            if (count[c] > 1) jobs.push_back({s + bucketStart, count[c], job.depth + 1});
+            bucketStart += count[c];
+        }
+    }
+}
+
+inline void lcpMerge(const unsigned char* base, const StringSlot* a, const uint32_t* lcpA, size_t aLen,
+                     const StringSlot* b, const uint32_t* lcpB, size_t bLen, StringSlot* out, uint32_t* lcpOut){
+    // merges two sorted runs with their lcp arrays. hA and hB are the common prefix lengths of the
+    // last string written with a[x] and b[y]. if they differ the one with the longer common prefix is
+    // smaller without looking at it, otherwise the comparison starts after the shared prefix.
+    // stable: on equal strings a goes first
+    size_t x = 0;
+    size_t y = 0;
+    size_t hA = 0;
+    size_t hB = 0;
+    while (x < aLen && y < bLen){
+        if (hA > hB){
+            *out++ = a[x];
+            *lcpOut++ = hA;
+            x++;
+            hA = x < aLen ? lcpA[x] : 0;
+        }
+        else if (hB > hA){
+            *out++ = b[y];
+            *lcpOut++ = hB;
+            y++;
+            hB = y < bLen ? lcpB[y] : 0;
+        }
+        else {
+            size_t h = lcpFrom(base, a[x], b[y], hA);
+            bool takeB = h < a[x].length && (h == b[y].length || base[b[y].offset + h] < base[a[x].offset + h]);
+            if (takeB){
+                *out++ = b[y];
+                *lcpOut++ = hB;
+                y++;
+                hA = h;
+                hB = y < bLen ? lcpB[y] : 0;
+            }
+            else {
+                *out++ = a[x];
+                *lcpOut++ = hA;
+                x++;
+                hB = h;
+                hA = x < aLen ? lcpA[x] : 0;
+            }
+        }
+    }
+    // finish up the remaining run, the first of its strings still needs the lcp with the last written one
+    for (; x < aLen; x++){
+        *out++ = a[x];
+        *lcpOut++ = hA;
+        hA = x + 1 < aLen ? lcpA[x+1] : 0;
+    }
+    for (; y < bLen; y++){
+        *out++ = b[y];
+        *lcpOut++ = hB;
+        hB = y + 1 < bLen ? lcpB[y+1] : 0;
+    }
+}
+
+inline void lcpMergeSortPingPong(const unsigned char* base, StringSlot* src, StringSlot* dst, uint32_t* srcLcp,
+                                 uint32_t* dstLcp, size_t n, bool intoDst){
+    // same ping-pong layout as mergeSortPingPong, the lcp arrays travel along with the slots
+    if (n <= stringInsertionCutoff){
+        stringInsertionSort(base, src, n, 0);
+        stringLcpArray(base, src, n, srcLcp);
+        if (intoDst){
+            std::memcpy(dst, src, n*sizeof(StringSlot));
+            std::memcpy(dstLcp, srcLcp, n*sizeof(uint32_t));
+        }
+        return;
+    }
+    size_t half = n/2;
+    lcpMergeSortPingPong(base, src, dst, srcLcp, dstLcp, half, !intoDst);
+    lcpMergeSortPingPong(base, src + half, dst + half, srcLcp + half, dstLcp + half, n - half, !intoDst);
+    if (intoDst) lcpMerge(base, src, srcLcp, half, src + half, srcLcp + half, n - half, dst, dstLcp);
+    else lcpMerge(base, dst, dstLcp, half, dst + half, dstLcp + half, n - half, src, srcLcp);
+}
+
+inline void lcpMergeSort(const unsigned char* base, StringSlot* slots, size_t n, uint32_t* lcp){
+    // lcp receives the lcp array of the sorted result
+    if (n < 2){
+        stringLcpArray(base, slots, n, lcp);
+        return;
+    }
+    std::vector<StringSlot> buffer(n);
+    std::vector<uint32_t> lcpBuffer(n);
+    lcpMergeSortPingPong(base, slots, buffer.data(), lcp, lcpBuffer.data(), n, false);
+}
+
+inline void sortStringRange(const unsigned char* base, StringSlot* slots, size_t n, StringEngine engine){
+    switch (engine){
+        case StringEngine::Multikey: multikeyQuickSort(base, slots, n); break;
+        case StringEngine::Msd: msdRadixSort(base, slots, n); break;
+        case StringEngine::LcpMerge: {
+            std::vector<uint32_t> lcp(n);
+            lcpMergeSort(base, slots, n, lcp.data());
+            break;
+        }
+    }
+}
+
+inline void sortStrings(StringArena& arena, StringEngine engine, int threads = 1){
+    // sorts the arena's slots. with more than one thread the slots are cut into one chunk per
+    // thread, the chunks are sorted concurrently and then merged pairwise with the lcp merge
+    const unsigned char* base = arena.bytes.data();
+    StringSlot* slots = arena.slots.data();
+    size_t n = arena.size();
+    if (threads <= 1 || n < 2*(size_t)threads){
+        sortStringRange(base, slots, n, engine);
+        return;
+    }
+
+    std::vector<StringSlot> buffer(n);
+    std::vector<uint32_t> lcp(n);
+    std::vector<uint32_t> lcpBuffer(n);
+    uint32_t* lcpData = lcp.data();
+    size_t chunk = (n + threads - 1)/threads;
+    std::vector<std::thread> workers;
+    for (size_t start=0; start<n; start+=chunk){
+        size_t len = std::min(chunk, n - start);
+        workers.emplace_back([=](){
+            if (engine == StringEngine::LcpMerge) lcpMergeSort(base, slots + start, len, lcpData + start);
+            else {
+                sortStringRange(base, slots + start, len, engine);
+                stringLcpArray(base, slots + start, len, lcpData + start);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    StringSlot* src = slots;
+    StringSlot* dst = buffer.data();
+    uint32_t* srcLcp = lcpData;
+    uint32_t* dstLcp = lcpBuffer.data();
+    for (size_t width=chunk; width<n; width*=2){
+        workers.clear();
+        for (size_t start=0; start<n; start+=2*width){
+            size_t mid = std::min(start + width, n);
+            size_t end = std::min(start + 2*width, n);
+            workers.emplace_back([=](){
+                lcpMerge(base, src + start, srcLcp + start, mid - start, src + mid, srcLcp + mid, end - mid,
+                         dst + start, dstLcp + start);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        std::swap(src, dst);
+        std::swap(srcLcp, dstLcp);
+    }
+    if (src != slots) std::memcpy(slots, src, n*sizeof(StringSlot));
+}
+
+#endif // STRINGSORT_H
@@ -4,12 +4,21 @@
 #include <fstream>
 #include <thread>
 #include <mutex>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <sstream>
+#include <map>
+#include <sys/resource.h>
+#include "../sorting-networks/SortingNetworks.h"
+#include "../engines/SortTrace.h"
 
 using std::cout, std::vector;
 using std::chrono::high_resolution_clock, std::chrono::duration_cast, std::chrono::nanoseconds;
 
 vector<int> mergesort(vector<int> unsorted);
-vector<int> hybridSort(vector<int> unsorted, int threshold);
+vector<int> hybridSort(vector<int> unsorted, int threshold, int depth = 0);
+template <bool Traced> vector<int> hybridSortNode(vector<int> unsorted, int threshold, int depth);
 vector<int> insertionSort(vector<int> unsorted);
 vector<int> insertionSortForHybrid(vector<int> unsorted);
 void printVector(vector<int>);
@@ -19,10 +28,43 @@ void timeHybridSort();
 void timeMergeSort();
 void timeInsertionSort();
 void timeInsertionMergeSorts();
+void timeBlockMergeSort();
+void timeNetworkLeaves();
+void traceHybridSort(int sampleSize, int threshold);
+long peakRSS();
+
+// regression check against stored timings
+struct BaselineRow {
+    int sampleSize;
+    double timing;
+};
+int compareWithBaseline(int argc, char* argv[]);
+bool loadBaseline(const std::string& path, vector<BaselineRow>& rows);
+bool isKnownEngine(const std::string& engine);
+double normalizedTiming(const std::string& engine, int sampleSize, double timing);
+double timeEngineOnce(const std::string& engine, int sampleSize);
+double median(vector<double> values);
+double mannWhitneyGreater(const vector<double>& baseline, const vector<double>& current, double& minP);
+
+// block merge sort (stable, O(1) extra memory)
+void blockMergeSort(vector<int>& unsorted, int* extBuffer = nullptr, int extBufferLen = 0);
+void blockInsertionSort(int* arr, int start, int end);
+void rotateRange(int* arr, int start, int mid, int end);
+int blockLowerBound(int* arr, int len, int value);
+int blockUpperBound(int* arr, int len, int value);
+int collectKeys(int* arr, int len, int wanted);
+int swapMergeForward(int* arr, int start, int leftLen, int end, int* buf, bool leftWinsTies, bool& tailFromLeft);
+void swapMergeBackward(int* arr, int start, int mid, int end, int* buf);
+void rotationMerge(int* arr, int start, int mid, int end, bool leftWinsTies = true);
+int rotationMergeForward(int* arr, int start, int leftLen, int end, bool leftWinsTies, bool& tailFromLeft);
+void rotationMergeSort(int* arr, int len, int* extBuffer, int extBufferLen);
+void blockMerge(int* arr, int start, int mid, int end, int blockLen, int* keys, int* buf, int bufLen);
 
 uint64_t hybridKeyComp = 0;
 uint64_t mergeKeyComp = 0;
 uint64_t insertKeyComp = 0;
+uint64_t blockKeyComp = 0;
+uint64_t blockRotateMoves = 0; // elements moved by rotateRange, rotation merges are what make block merge sort slow
 
 int minSize = 1000;
 int maxSize = 10000000;
@@ -32,6 +74,19 @@ int thresholdTiming = 110;
 int thresholdKeyComp = 9;
 int trivialThreshold = 200;
 
+int blockRunSize = 16; // block merge sort builds runs of this size with insertion sort first
+int minBlockKeys = 4;  // with this many distinct values or fewer block merge sort only uses rotation merges
+int blockExtBufferLen = 0; // 0 = fully in-place, otherwise size of the external scratch buffer
+
+bool networkLeaves = false; // hybridSort sorts leaves of <= 32 elements with a sorting network instead of insertion sort
+
+double regressionThreshold = 10.0; // percent slowdown of the median before a size counts as a regression
+int compareReps = 5;               // runs per size for the new timings
+int compareWindow = 2;             // baseline sizes on either side that are pooled into the baseline sample
+int compareStride = 1;             // only rerun every n-th baseline size
+int compareMaxSize = 0;            // skip baseline sizes above this (0 = no limit)
+double compareAlpha = 0.05;        // significance level of the Mann-Whitney test
+
 std::mutex file_mutex;
 
 int main(int argc, char* argv[]){
@@ -42,7 +97,33 @@ int main(int argc, char* argv[]){
     // thread1.join();
     // thread2.join();
     // thread3.join();
-    timeHybridSort();
+
+    // run one engine per process so the peak RSS column only reflects that engine
+    // usage: ./a.out [hybrid|block|network|test] [external buffer length for block]
+    //        ./a.out trace [sample size] [threshold], see traceHybridSort
+    //        ./a.out compare engine=baseline.csv... [options], see compareWithBaseline
+    std::string mode = argc > 1 ? argv[1] : "hybrid";
+    if (mode == "block"){
+        if (argc > 2) blockExtBufferLen = atoi(argv[2]);
+        timeBlockMergeSort();
+    }
+    else if (mode == "network"){
+        timeNetworkLeaves();
+    }
+    else if (mode == "trace"){
+        int sampleSize = argc > 2 ? atoi(argv[2]) : 1000000;
+        int threshold = argc > 3 ? atoi(argv[3]) : trivialThreshold;
+        traceHybridSort(sampleSize, threshold);
+    }
+    else if (mode == "compare"){
+        return compareWithBaseline(argc, argv);
+    }
+    else if (mode == "test"){
+        testSorting();
+    }
+    else {
+        timeHybridSort();
+    }
     
     cout << "All sorting operations completed.\n";
     return 0;
@@ -138,7 +219,8 @@ void timeHybridSort() {
             cout << "Error opening timingsHybrid.csv for writing.\n";
             return;
         }
-        file << "sampleSize,timing,keycomp\n";
+        file << "sampleSize,timing,keycomp,peakRSS\n";
+        file.close();
     }
 
     cout << "starting HybridSort timing\n";
@@ -163,7 +245,7 @@ void timeHybridSort() {
                 cout << "Error opening timingsHybrid.csv for writing.\n";
                 return;
             }
-            file << test.size() << "," << durationHybridSort.count() << "," << hybridKeyComp << "\n";
+            file << test.size() << "," << durationHybridSort.count() << "," << hybridKeyComp << "," << peakRSS() << "\n";
             file.close();
         }
 
@@ -260,66 +342,473 @@ void timeInsertionSort() {
     cout << "InsertionSort Done!\n";
 }
 
+void timeBlockMergeSort() {
+    std::ofstream file;
+    vector<int> extBuffer(blockExtBufferLen);
+
+    {
+        std::lock_guard<std::mutex> lock(file_mutex);
+        file.open("timingsBlockMerge.csv", std::ios::app);
+        if (!file.is_open()) {
+            cout << "Error opening timingsBlockMerge.csv for writing.\n";
+            return;
+        }
+        file << "sampleSize,timing,keycomp,peakRSS\n";
+        file.close();
+    }
+
+    cout << "starting BlockMergeSort timing (external buffer: " << blockExtBufferLen << ")\n";
+    for (int i = minSize; i < maxSize; i += step) {
+        cout << "BlockMergeSort timing for " << i << "\n";
+        vector<int> test;
+        for (int j = i; j > 0; j--) {
+            int randomNum = rand() % i;
+            test.push_back(randomNum);
+        }
+
+        // sorts test in place, so unlike hybridSort there is no copy of the input
+        auto startBlockMergeSort = high_resolution_clock::now();
+        blockMergeSort(test, extBuffer.data(), blockExtBufferLen);
+        auto stopBlockMergeSort = high_resolution_clock::now();
+        auto durationBlockMergeSort = duration_cast<nanoseconds>(stopBlockMergeSort - startBlockMergeSort);
+
+        {
+            std::lock_guard<std::mutex> lock(file_mutex);
+            file.open("timingsBlockMerge.csv", std::ios::app);
+            if (!file.is_open()) {
+                cout << "Error opening timingsBlockMerge.csv for writing.\n";
+                return;
+            }
+            file << test.size() << "," << durationBlockMergeSort.count() << "," << blockKeyComp << "," << peakRSS() << "\n";
+            file.close();
+        }
+
+        blockKeyComp = 0;
+    }
+    cout << "BlockMergeSort Done!\n";
+}
+
+void timeNetworkLeaves() {
+    std::ofstream file;
+    int trials = 100000;
+
+    // part 1: each leaf size on its own, network vs insertion sort, both the way hybridSort runs
+    // its leaves: a leaf is its own vector, sorted in place by the network or handed to
+    // insertionSortForHybrid (counted in hybridKeyComp)
+    file.open("timingsNetwork.csv", std::ios::app);
+    if (!file.is_open()) {
+        cout << "Error opening timingsNetwork.csv for writing.\n";
+        return;
+    }
+    file << "n,networkComp,insertionComp,networkTiming,insertionTiming\n";
+    cout << "starting sorting network timing\n";
+    for (int n = 2; n <= maxNetworkSize; n++) {
+        vector<vector<int>> networkLeafPool;
+        for (int t = 0; t < trials; t++) {
+            vector<int> leaf;
+            for (int j = n; j > 0; j--) {
+                leaf.push_back(rand());
+            }
+            networkLeafPool.push_back(leaf);
+        }
+        vector<vector<int>> insertionLeafPool = networkLeafPool;
+
+        auto startNetwork = high_resolution_clock::now();
+        for (int t = 0; t < trials; t++) {
+            sort_small(networkLeafPool[t].data(), n);
+        }
+        auto stopNetwork = high_resolution_clock::now();
+
+        hybridKeyComp = 0;
+        auto startInsertion = high_resolution_clock::now();
+        for (int t = 0; t < trials; t++) {
+            insertionLeafPool[t] = insertionSortForHybrid(insertionLeafPool[t]);
+        }
+        auto stopInsertion = high_resolution_clock::now();
+
+        // per sort averages; the network always does network_size(n) comparisons
+        double networkTiming = (double)duration_cast<nanoseconds>(stopNetwork - startNetwork).count() / trials;
+        double insertionTiming = (double)duration_cast<nanoseconds>(stopInsertion - startInsertion).count() / trials;
+        double insertionComp = (double)hybridKeyComp / trials;
+        cout << "n=" << n << " network: " << network_size(n) << " comps " << networkTiming << "ns"
+             << ", insertion: " << insertionComp << " comps " << insertionTiming << "ns\n";
+        file << n << "," << network_size(n) << "," << insertionComp << "," << networkTiming << "," << insertionTiming << "\n";
+        hybridKeyComp = 0;
+    }
+    file.close();
+
+    // part 2: whole hybridSort runs with insertion sort leaves vs network leaves
+    file.open("timingsNetworkHybrid.csv", std::ios::app);
+    if (!file.is_open()) {
+        cout << "Error opening timingsNetworkHybrid.csv for writing.\n";
+        return;
+    }
+    file << "threshold,leaves,sampleSize,timing,keycomp\n";
+    vector<int> sizes = {100000, 1000000};
+    vector<int> thresholds = {8, 16, 32};
+    for (int size : sizes) {
+        vector<int> test;
+        for (int j = size; j > 0; j--) {
+            test.push_back(rand() % size);
+        }
+        for (int threshold : thresholds) {
+            for (bool useNetwork : {false, true}) {
+                networkLeaves = useNetwork;
+                hybridKeyComp = 0;
+                auto startHybridSort = high_resolution_clock::now();
+                vector<int> res = hybridSort(test, threshold);
+                auto stopHybridSort = high_resolution_clock::now();
+                auto durationHybridSort = duration_cast<nanoseconds>(stopHybridSort - startHybridSort);
+                std::string leaves = useNetwork ? "network" : "insertion";
+                cout << "HybridSort " << size << " threshold " << threshold << " " << leaves << " leaves: "
+                     << durationHybridSort.count() << "ns, " << hybridKeyComp << " comps\n";
+                file << threshold << "," << leaves << "," << size << "," << durationHybridSort.count() << "," << hybridKeyComp << "\n";
+            }
+        }
+    }
+    networkLeaves = false;
+    hybridKeyComp = 0;
+    file.close();
+    cout << "Sorting network timing Done!\n";
+}
+
+void traceHybridSort(int sampleSize, int threshold) {
+    // one traced hybridSort call: shows whether the time goes into the leaves, the merges or the
+    // firstHalf/secondHalf copies at each recursion depth. writes traceHybrid.json, which can be
+    // opened in chrome://tracing or ui.perfetto.dev, and prints the per-depth totals
+    vector<int> test = {};
+    for (int j=sampleSize; j>0; j--){
+        test.push_back(rand() % sampleSize);
+    }
+
+    // one span per node and phase, keep all of them unless the input is huge
+    traceRingCapacity = std::max<size_t>(traceRingCapacity, 8 * (size_t)(sampleSize / std::max(threshold, 1) + 1));
+    traceReset();
+    hybridKeyComp = 0;
+    sortTraceEnabled = true;
+    auto startHybridSort = high_resolution_clock::now();
+    vector<int> res = hybridSort(test, threshold);
+    auto stopHybridSort = high_resolution_clock::now();
+    sortTraceEnabled = false;
+    auto durationHybridSort = duration_cast<nanoseconds>(stopHybridSort-startHybridSort);
+
+    cout << "traced hybridSort of " << sampleSize << " elements, threshold " << threshold << ": "
+         << durationHybridSort.count() / 1e6 << " ms, " << hybridKeyComp << " key comparisons\n";
+    printTraceSummary(cout);
+    if (!writeChromeTrace("traceHybrid.json", "hybridSort")){
+        cout << "Error opening traceHybrid.json for writing.\n";
+        return;
+    }
+    cout << "wrote traceHybrid.json\n";
+    hybridKeyComp = 0;
+}
+
+// usage: ./a.out compare hybrid=timingsHybrid.csv merge=timingsMerge.csv ...
+//            [--threshold percent] [--reps n] [--window n] [--stride n] [--max-size n]
+// engines are hybrid, merge, insertion and block. every size in the baseline file is timed again
+// --reps times on the same kind of input (rand() % size). timings are normalized by the engine's
+// complexity (n log n, n^2 for insertion) so neighbouring baseline sizes can be pooled into one
+// baseline sample (--window sizes on each side), which matters since the stored files only have
+// one timing per size. a size is flagged when the median got slower by more than --threshold
+// percent and a one-sided Mann-Whitney U test says the slowdown is significant. if the samples
+// are too small for the test to ever reach significance, the threshold alone decides.
+// returns 2 when anything regressed, 1 on bad arguments, 0 otherwise.
+int compareWithBaseline(int argc, char* argv[]){
+    vector<std::pair<std::string, std::string>> baselines;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threshold" && hasValue) regressionThreshold = atof(argv[++i]);
+        else if (arg == "--reps" && hasValue) compareReps = std::max(1, atoi(argv[++i]));
+        else if (arg == "--window" && hasValue) compareWindow = std::max(0, atoi(argv[++i]));
+        else if (arg == "--stride" && hasValue) compareStride = std::max(1, atoi(argv[++i]));
+        else if (arg == "--max-size" && hasValue) compareMaxSize = atoi(argv[++i]);
+        else if (arg.find('=') != std::string::npos) {
+            std::string engine = arg.substr(0, arg.find('='));
+            if (!isKnownEngine(engine)) {
+                cout << "Unknown engine " << engine << " (hybrid, merge, insertion, block)\n";
+                return 1;
+            }
+            baselines.push_back({engine, arg.substr(arg.find('=') + 1)});
+        }
+        else {
+            cout << "Unexpected argument " << arg << "\n";
+            return 1;
+        }
+    }
+    if (baselines.empty()) {
+        cout << "usage: ./a.out compare engine=baseline.csv... [--threshold percent] [--reps n] [--window n] [--stride n] [--max-size n]\n";
+        return 1;
+    }
+
+    std::map<std::string, vector<int>> regressions;
+    cout << "engine     size        baseline      current       change     p\n";
+    for (auto& [engine, path] : baselines) {
+        vector<BaselineRow> rows;
+        if (!loadBaseline(path, rows)) {
+            return 1;
+        }
+
+        // normalized baseline timings grouped by size, sizes in ascending order
+        std::map<int, vector<double>> bySize;
+        for (BaselineRow& row : rows) {
+            bySize[row.sampleSize].push_back(normalizedTiming(engine, row.sampleSize, row.timing));
+        }
+        vector<int> sizes;
+        for (auto& entry : bySize) {
+            sizes.push_back(entry.first);
+        }
+
+        for (int idx = 0; idx < (int)sizes.size(); idx += compareStride) {
+            int size = sizes[idx];
+            if (size <= 1 || (compareMaxSize > 0 && size > compareMaxSize)) continue;
+
+            vector<double> baseline;
+            int from = std::max(0, idx - compareWindow);
+            int to = std::min((int)sizes.size() - 1, idx + compareWindow);
+            for (int k = from; k <= to; k++) {
+                if (sizes[k] <= 1) continue;
+                baseline.insert(baseline.end(), bySize[sizes[k]].begin(), bySize[sizes[k]].end());
+            }
+            vector<double> current;
+            for (int rep = 0; rep < compareReps; rep++) {
+                current.push_back(normalizedTiming(engine, size, timeEngineOnce(engine, size)));
+            }
+
+            double baselineMedian = median(baseline);
+            double currentMedian = median(current);
+            double change = (currentMedian / baselineMedian - 1) * 100;
+            double minP;
+            double p = mannWhitneyGreater(baseline, current, minP);
+            bool testable = minP < compareAlpha;
+            bool slower = change > regressionThreshold && (!testable || p < compareAlpha);
+            if (slower) {
+                regressions[engine].push_back(size);
+            }
+
+            char line[160];
+            snprintf(line, sizeof(line), "%-10s %-11d %-13.5g %-13.5g %+-10.1f %-7s %s\n",
+                     engine.c_str(), size, baselineMedian, currentMedian, change,
+                     testable ? std::to_string(p).substr(0, 6).c_str() : "-", slower ? "SLOWER" : "");
+            cout << line;
+        }
+    }
+
+    if (regressions.empty()) {
+        cout << "No regressions above " << regressionThreshold << "%\n";
+        return 0;
+    }
+    for (auto& [engine, slowSizes] : regressions) {
+        cout << "REGRESSION " << engine << ": " << slowSizes.size() << " size(s) slower:";
+        for (int size : slowSizes) {
+            cout << " " << size;
+        }
+        cout << "\n";
+    }
+    return 2;
+}
+
+bool loadBaseline(const std::string& path, vector<BaselineRow>& rows){
+    // reads sampleSize,timing,... rows; the header is repeated once per appended run, so any
+    // line that does not start with a number is skipped
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        cout << "Error opening " << path << " for reading.\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || !isdigit((unsigned char)line[0])) continue;
+        std::stringstream fields(line);
+        std::string sampleSize;
+        std::string timing;
+        if (!std::getline(fields, sampleSize, ',') || !std::getline(fields, timing, ',')) continue;
+        rows.push_back({atoi(sampleSize.c_str()), atof(timing.c_str())});
+    }
+    if (rows.empty()) {
+        cout << "No timings found in " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool isKnownEngine(const std::string& engine){
+    return engine == "hybrid" || engine == "merge" || engine == "insertion" || engine == "block";
+}
+
+double normalizedTiming(const std::string& engine, int sampleSize, double timing){
+    // ns per n log2 n (ns per n^2 for insertion sort) so different sizes are comparable
+    double n = sampleSize;
+    if (engine == "insertion") return timing / (n * n);
+    return timing / (n * std::log2(n));
+}
+
+double timeEngineOnce(const std::string& engine, int sampleSize){
+    vector<int> test;
+    for (int j = sampleSize; j > 0; j--) {
+        test.push_back(rand() % sampleSize);
+    }
+    vector<int> res;
+    auto start = high_resolution_clock::now();
+    if (engine == "hybrid") res = hybridSort(test, trivialThreshold);
+    else if (engine == "merge") res = mergesort(test);
+    else if (engine == "insertion") res = insertionSort(test);
+    else blockMergeSort(test);
+    auto stop = high_resolution_clock::now();
+    hybridKeyComp = 0;
+    mergeKeyComp = 0;
+    insertKeyComp = 0;
+    blockKeyComp = 0;
+    return duration_cast<nanoseconds>(stop - start).count();
+}
+
+double median(vector<double> values){
+    std::sort(values.begin(), values.end());
+    int n = values.size();
+    if (n % 2 == 1) return values[n/2];
+    return (values[n/2 - 1] + values[n/2]) / 2;
+}
+
+double mannWhitneyGreater(const vector<double>& baseline, const vector<double>& current, double& minP){
+    // one-sided Mann-Whitney U test, returns the p value for "current is slower than baseline".
+    // minP is the smallest p value these sample sizes could give at all.
+    // exact distribution for small samples without ties, normal approximation otherwise
+    int m = baseline.size();
+    int n = current.size();
+    double u = 0;
+    bool ties = false;
+    for (double b : baseline) {
+        for (double c : current) {
+            if (c > b) u += 1;
+            else if (c == b) {
+                u += 0.5;
+                ties = true;
+            }
+        }
+    }
+
+    // ways[j][k]: orderings of i baseline and j current values with U = k, built up over i.
+    // the largest value is either a baseline value (adds 0) or a current one (adds i)
+    vector<vector<double>> ways(n + 1, vector<double>(m*n + 1, 0));
+    for (int j = 0; j <= n; j++) ways[j][0] = 1;
+    for (int i = 1; i <= m; i++) {
+        for (int j = 1; j <= n; j++) {
+            for (int k = m*n; k >= 0; k--) {
+                ways[j][k] = ways[j][k] + (k >= i ? ways[j-1][k-i] : 0);
+            }
+        }
+    }
+    double total = 0;
+    for (double w : ways[n]) total += w;
+    minP = ways[n][m*n] / total;
+
+    if (!ties && m + n <= 40) {
+        double atLeast = 0;
+        for (int k = (int)u; k <= m*n; k++) atLeast += ways[n][k];
+        return atLeast / total;
+    }
+
+    std::map<double, int> counts;
+    for (double b : baseline) counts[b]++;
+    for (double c : current) counts[c]++;
+    double tieTerm = 0;
+    for (auto& entry : counts) {
+        double t = entry.second;
+        tieTerm += t*t*t - t;
+    }
+    double sampleCount = m + n;
+    double mean = m * n / 2.0;
+    double variance = m * n / 12.0 * ((sampleCount + 1) - tieTerm / (sampleCount * (sampleCount - 1)));
+    if (variance <= 0) return 1;
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+long peakRSS(){
+    // peak resident set size of this process so far, in KiB (linux reports ru_maxrss in KiB)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
 void testSorting() {
     // Test case 1: Already sorted array
     vector<int> sorted_1 = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
     vector<int> result_hybrid_1 = hybridSort(sorted_1, 2);
     vector<int> result_merge_1 = mergesort(sorted_1);
     vector<int> result_insertion_1 = insertionSort(sorted_1);
+    vector<int> result_block_1 = sorted_1;
+    blockMergeSort(result_block_1);
     cout << "Test case 1: Already sorted array\n";
     printVector(result_hybrid_1);
     printVector(result_merge_1);
     printVector(result_insertion_1);
+    printVector(result_block_1);
 
     // Test case 2: Reverse sorted array
     vector<int> unsorted_2 = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
     vector<int> result_hybrid_2 = hybridSort(unsorted_2, 2);
     vector<int> result_merge_2 = mergesort(unsorted_2);
     vector<int> result_insertion_2 = insertionSort(unsorted_2);
+    vector<int> result_block_2 = unsorted_2;
+    blockMergeSort(result_block_2);
     cout << "Test case 2: Reverse sorted array\n";
     printVector(result_hybrid_2);
     printVector(result_merge_2);
     printVector(result_insertion_2);
+    printVector(result_block_2);
 
     // Test case 3: Random array
     vector<int> unsorted_3 = {3, 6, 2, 8, 4, 7, 1, 10, 5, 9};
     vector<int> result_hybrid_3 = hybridSort(unsorted_3, 2);
     vector<int> result_merge_3 = mergesort(unsorted_3);
     vector<int> result_insertion_3 = insertionSort(unsorted_3);
+    vector<int> result_block_3 = unsorted_3;
+    blockMergeSort(result_block_3);
     cout << "Test case 3: Random array\n";
     printVector(result_hybrid_3);
     printVector(result_merge_3);
     printVector(result_insertion_3);
+    printVector(result_block_3);
 
     // Test case 4: Empty array
     vector<int> unsorted_4 = {};
     vector<int> result_hybrid_4 = hybridSort(unsorted_4, 2);
     vector<int> result_merge_4 = mergesort(unsorted_4);
     vector<int> result_insertion_4 = insertionSort(unsorted_4);
+    vector<int> result_block_4 = unsorted_4;
+    blockMergeSort(result_block_4);
     cout << "Test case 4: Empty array\n";
     printVector(result_hybrid_4);
     printVector(result_merge_4);
     printVector(result_insertion_4);
+    printVector(result_block_4);
 
     // Test case 5: Single element array
     vector<int> unsorted_5 = {42};
     vector<int> result_hybrid_5 = hybridSort(unsorted_5, 2);
     vector<int> result_merge_5 = mergesort(unsorted_5);
     vector<int> result_insertion_5 = insertionSort(unsorted_5);
+    vector<int> result_block_5 = unsorted_5;
+    blockMergeSort(result_block_5);
     cout << "Test case 5: Single element array\n";
     printVector(result_hybrid_5);
     printVector(result_merge_5);
     printVector(result_insertion_5);
+    printVector(result_block_5);
 
     // Test case 6: Array with duplicates
     vector<int> unsorted_6 = {5, 3, 8, 3, 9, 1, 5, 3, 2, 8};
     vector<int> result_hybrid_6 = hybridSort(unsorted_6, 2);
     vector<int> result_merge_6 = mergesort(unsorted_6);
     vector<int> result_insertion_6 = insertionSort(unsorted_6);
+    vector<int> result_block_6 = unsorted_6;
+    blockMergeSort(result_block_6);
     cout << "Test case 6: Array with duplicates\n";
     printVector(result_hybrid_6);
     printVector(result_merge_6);
     printVector(result_insertion_6);
+    printVector(result_block_6);
 
     // Assert that all results match the expected sorted vector for each case
     vector<int> expected = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
@@ -335,29 +824,130 @@ void testSorting() {
     assertEqual(result_hybrid_1, expected, "HybridSort Test Case 1");
     assertEqual(result_merge_1, expected, "MergeSort Test Case 1");
     assertEqual(result_insertion_1, expected, "InsertionSort Test Case 1");
+    assertEqual(result_block_1, expected, "BlockMergeSort Test Case 1");
 
     assertEqual(result_hybrid_2, expected, "HybridSort Test Case 2");
     assertEqual(result_merge_2, expected, "MergeSort Test Case 2");
     assertEqual(result_insertion_2, expected, "InsertionSort Test Case 2");
+    assertEqual(result_block_2, expected, "BlockMergeSort Test Case 2");
 
     assertEqual(result_hybrid_3, expected, "HybridSort Test Case 3");
     assertEqual(result_merge_3, expected, "MergeSort Test Case 3");
     assertEqual(result_insertion_3, expected, "InsertionSort Test Case 3");
+    assertEqual(result_block_3, expected, "BlockMergeSort Test Case 3");
 
     vector<int> expected_4 = {};
     assertEqual(result_hybrid_4, expected_4, "HybridSort Test Case 4");
     assertEqual(result_merge_4, expected_4, "MergeSort Test Case 4");
     assertEqual(result_insertion_4, expected_4, "InsertionSort Test Case 4");
+    assertEqual(result_block_4, expected_4, "BlockMergeSort Test Case 4");
 
     vector<int> expected_5 = {42};
     assertEqual(result_hybrid_5, expected_5, "HybridSort Test Case 5");
     assertEqual(result_merge_5, expected_5, "MergeSort Test Case 5");
     assertEqual(result_insertion_5, expected_5, "InsertionSort Test Case 5");
+    assertEqual(result_block_5, expected_5, "BlockMergeSort Test Case 5");
 
     vector<int> expected_6 = {1, 2, 3, 3, 3, 5, 5, 8, 8, 9};
     assertEqual(result_hybrid_6, expected_6, "HybridSort Test Case 6");
     assertEqual(result_merge_6, expected_6, "MergeSort Test Case 6");
     assertEqual(result_insertion_6, expected_6, "InsertionSort Test Case 6");
+    assertEqual(result_block_6, expected_6, "BlockMergeSort Test Case 6");
+
+    // Test case 7: Larger arrays so block merge sort goes past its insertion sort runs,
+    // once with plenty of distinct keys, once with too few (smaller buffer), once with an external buffer
+    vector<int> unsorted_7;
+    vector<int> unsorted_7_dups;
+    for (int i = 0; i < 100000; i++) {
+        unsorted_7.push_back(rand() % 100000);
+        unsorted_7_dups.push_back(rand() % 50);
+    }
+    vector<int> expected_7 = mergesort(unsorted_7);
+    vector<int> expected_7_dups = mergesort(unsorted_7_dups);
+    vector<int> result_block_7 = unsorted_7;
+    vector<int> result_block_7_dups = unsorted_7_dups;
+    vector<int> result_block_7_buffer = unsorted_7;
+    vector<int> extBuffer(512);
+    blockMergeSort(result_block_7);
+    blockMergeSort(result_block_7_dups);
+    blockMergeSort(result_block_7_buffer, extBuffer.data(), extBuffer.size());
+    assertEqual(result_block_7, expected_7, "BlockMergeSort Test Case 7");
+    assertEqual(result_block_7_dups, expected_7_dups, "BlockMergeSort Test Case 7 (few distinct keys)");
+    assertEqual(result_block_7_buffer, expected_7, "BlockMergeSort Test Case 7 (external buffer)");
+
+    // Test case 8: HybridSort with sorting network leaves, every leaf size up to 32 gets used
+    vector<int> result_network_8;
+    networkLeaves = true;
+    for (int threshold = 2; threshold <= maxNetworkSize; threshold++) {
+        result_network_8 = hybridSort(unsorted_7, threshold);
+        if (result_network_8 != expected_7) break;
+    }
+    networkLeaves = false;
+    assertEqual(result_network_8, expected_7, "HybridSort (network leaves) Test Case 8");
+
+    // Test case 9: every network up to 26 elements sorts all 0-1 inputs (so it sorts everything).
+    // above that the 2^n inputs take too long, so the merged networks from 17 up are also run on
+    // the 0-1 thresholds of random permutations (dropping any one comparator of the 32 network
+    // fails this check)
+    int unsortedNetwork = 0;
+    for (int n = 0; n <= 26 && unsortedNetwork == 0; n++) {
+        if (!sortsZeroOne(makeNetwork(n), n)) unsortedNetwork = n;
+    }
+    if (unsortedNetwork == 0) cout << "SortingNetworks (0-1 principle) Test Case 9 passed.\n";
+    else cout << "SortingNetworks (0-1 principle) Test Case 9 failed for " << unsortedNetwork << " elements.\n";
+    unsortedNetwork = 0;
+    for (int n = 17; n <= maxNetworkSize && unsortedNetwork == 0; n++) {
+        if (!sortsRandomZeroOne(makeNetwork(n), n, 50000, 0x9E3779B97F4A7C15ull + n)) unsortedNetwork = n;
+    }
+    if (unsortedNetwork == 0) cout << "SortingNetworks (random 0-1 inputs) Test Case 9 passed.\n";
+    else cout << "SortingNetworks (random 0-1 inputs) Test Case 9 failed for " << unsortedNetwork << " elements.\n";
+
+    // Test case 10: block merge sort with a key count just below what it wants (1M elements want
+    // ~2000 keys, there are 1500 distinct values) has to stay about as fast as with all distinct
+    // values, and with only 3 distinct values it takes the rotation fallback
+    vector<int> unsorted_10_distinct;
+    vector<int> unsorted_10_keys;
+    vector<int> unsorted_10_rotation;
+    for (int i = 0; i < 1000000; i++) {
+        unsorted_10_distinct.push_back(rand());
+        unsorted_10_keys.push_back(rand() % 1500);
+        unsorted_10_rotation.push_back(rand() % 3);
+    }
+    vector<int> expected_10_distinct = unsorted_10_distinct;
+    vector<int> expected_10_keys = unsorted_10_keys;
+    vector<int> expected_10_rotation = unsorted_10_rotation;
+    std::sort(expected_10_distinct.begin(), expected_10_distinct.end());
+    std::sort(expected_10_keys.begin(), expected_10_keys.end());
+    std::sort(expected_10_rotation.begin(), expected_10_rotation.end());
+    blockKeyComp = 0;
+    blockRotateMoves = 0;
+    auto start = high_resolution_clock::now();
+    blockMergeSort(unsorted_10_distinct);
+    auto stop = high_resolution_clock::now();
+    double distinctTiming = duration_cast<nanoseconds>(stop - start).count();
+    uint64_t distinctComp = blockKeyComp;
+    uint64_t distinctMoves = blockRotateMoves;
+    blockKeyComp = 0;
+    blockRotateMoves = 0;
+    start = high_resolution_clock::now();
+    blockMergeSort(unsorted_10_keys);
+    stop = high_resolution_clock::now();
+    double keysTiming = duration_cast<nanoseconds>(stop - start).count();
+    uint64_t keysComp = blockKeyComp;
+    uint64_t keysMoves = blockRotateMoves;
+    blockMergeSort(unsorted_10_rotation);
+    cout << "BlockMergeSort 1000000 elements: " << distinctTiming/1e6 << "ms, " << distinctComp << " comparisons, "
+         << distinctMoves << " rotated all distinct / " << keysTiming/1e6 << "ms, " << keysComp << " comparisons, "
+         << keysMoves << " rotated with 1500 distinct values\n";
+    assertEqual(unsorted_10_distinct, expected_10_distinct, "BlockMergeSort Test Case 10");
+    assertEqual(unsorted_10_keys, expected_10_keys, "BlockMergeSort Test Case 10 (1500 distinct keys)");
+    assertEqual(unsorted_10_rotation, expected_10_rotation, "BlockMergeSort Test Case 10 (rotation fallback)");
+    // with all keys found, rotations only collect the keys and merge them back in: O(n + keys^2).
+    // with 1500 keys the merges still go through the buffer, only blocks that outgrew it are merged
+    // by rotation, so both counts stay within a small factor of the all distinct run (1.5x and 1.1x
+    // today). the old rotation fallback rotated whole runs: 2.3x the comparisons and ~500x the moves
+    if (keysComp <= 2*distinctComp && keysMoves <= 2*distinctMoves) cout << "BlockMergeSort (few keys work) Test Case 10 passed.\n";
+    else cout << "BlockMergeSort (few keys work) Test Case 10 failed.\n";
 }
 
 
@@ -449,7 +1039,17 @@ vector<int> insertionSortForHybrid(vector<int> unsorted){
     return unsorted;
 }
 
-vector<int> hybridSort(vector<int> unsorted, int threshold){
+vector<int> hybridSort(vector<int> unsorted, int threshold, int depth){
+    // the trace scopes only exist in the instantiation picked while sortTraceEnabled is set (see
+    // ./a.out trace), untimed runs recurse without them
+    if (sortTraceEnabled) return hybridSortNode<true>(unsorted, threshold, depth);
+    return hybridSortNode<false>(unsorted, threshold, depth);
+}
+
+template <bool Traced>
+vector<int> hybridSortNode(vector<int> unsorted, int threshold, int depth){
+    using Scope = TraceScopeIf<Traced>;
+    Scope node(TracePhase::Node, depth, unsorted.size(), &hybridKeyComp);
     
     hybridKeyComp++;
     if (unsorted.size() <= 1){
@@ -459,23 +1059,36 @@ vector<int> hybridSort(vector<int> unsorted, int threshold){
 
     hybridKeyComp++;
     if (unsorted.size() <= threshold){
+        Scope leaf(TracePhase::Leaf, depth, unsorted.size(), &hybridKeyComp);
+        if (networkLeaves && unsorted.size() <= maxNetworkSize){
+            // fixed number of comparisons for a given size
+            hybridKeyComp += network_size(unsorted.size());
+            sort_small(unsorted.data(), unsorted.size());
+            return unsorted;
+        }
         return insertionSortForHybrid(unsorted);
     }
 
     // split vector into 2
     int halfLen = unsorted.size()/2;
-    // vector slicing can be done using the copy constructor
-    // https://stackoverflow.com/questions/50549611/slicing-a-vector-in-c
-    auto startPtr = unsorted.begin();
-    vector<int> firstHalf = vector<int> (startPtr, startPtr + halfLen);
-    vector<int> secondHalf = vector<int> (startPtr + halfLen, unsorted.end());
+    vector<int> firstHalf;
+    vector<int> secondHalf;
+    {
+        Scope split(TracePhase::Split, depth, unsorted.size());
+        // vector slicing can be done using the copy constructor
+        // https://stackoverflow.com/questions/50549611/slicing-a-vector-in-c
+        auto startPtr = unsorted.begin();
+        firstHalf = vector<int> (startPtr, startPtr + halfLen);
+        secondHalf = vector<int> (startPtr + halfLen, unsorted.end());
+    }
 
     vector<int> sortedFirstHalf;
     vector<int> sortedSecondHalf;
 
-    sortedFirstHalf = hybridSort(firstHalf, threshold);
-    sortedSecondHalf = hybridSort(secondHalf, threshold);
+    sortedFirstHalf = hybridSortNode<Traced>(firstHalf, threshold, depth + 1);
+    sortedSecondHalf = hybridSortNode<Traced>(secondHalf, threshold, depth + 1);
 
+    Scope merge(TracePhase::Merge, depth, unsorted.size(), &hybridKeyComp);
     // create the resulting vector to place elements
     vector<int> result = {};
     int x = 0;
@@ -501,4 +1114,339 @@ vector<int> hybridSort(vector<int> unsorted, int threshold){
         result.push_back(sortedSecondHalf[y++]);
     }
     return result;
-}
\ No newline at end of file
+}
+// block merge sort: a stable merge sort that needs no temporaries (WikiSort/GrailSort style).
+// the first occurrences of ~2*sqrt(n) distinct values are pulled to the front of the array.
+// part of them tag the blocks during block merges, the rest is used as swap space for merging.
+// with fewer distinct values than that, the keys found are split into tags and a smaller buffer.
+// blocks grow on the long merges so the tags still cover them, and merges that don't fit in the
+// buffer use rotations. that stays cheap: blocks that outgrow the buffer are long stretches of a
+// run holding few distinct values. only with a handful of keys the sort merges by rotation alone.
+// if the caller has a scratch buffer of at least blockLen elements it is used for the merges
+// instead of the internal one (so fewer keys are needed), and the fallback uses it for short runs.
+void blockMergeSort(vector<int>& unsorted, int* extBuffer, int extBufferLen){
+    int len = unsorted.size();
+    int* arr = unsorted.data();
+    if (len <= 2*blockRunSize){
+        blockInsertionSort(arr, 0, len);
+        return;
+    }
+
+    // blocks of ~sqrt(n) elements, need one tag per block plus a buffer of one block
+    int blockLen = blockRunSize;
+    while ((long long)blockLen*blockLen < len){
+        blockLen *= 2;
+    }
+    int tagCount = len/blockLen + 1;
+    bool useExtBuffer = extBuffer != nullptr && extBufferLen >= blockLen;
+    int wanted = useExtBuffer ? tagCount : tagCount + blockLen;
+
+    int keyCount = collectKeys(arr, len, wanted);
+    if (keyCount <= minBlockKeys){
+        // keys were only taken from first occurrences, so equal elements are still in order
+        rotationMergeSort(arr, len, extBuffer, extBufferLen);
+        return;
+    }
+    int bufLen = useExtBuffer ? extBufferLen : blockLen;
+    if (keyCount < wanted){
+        // too few keys for a tag per block plus a whole block of buffer. with an external buffer all
+        // keys are tags, otherwise half of them are and the other half is a smaller buffer that the
+        // blocks shrink to fit. the merges grow the blocks again once they would run out of tags
+        tagCount = useExtBuffer ? keyCount : keyCount/2;
+        if (!useExtBuffer){
+            bufLen = keyCount - tagCount;
+            blockLen = blockRunSize;
+            while (blockLen*2 <= bufLen){
+                blockLen *= 2;
+            }
+        }
+    }
+
+    int* keys = arr;
+    int* buf = useExtBuffer ? extBuffer : arr + tagCount;
+    int* data = arr + keyCount;
+    int dataLen = len - keyCount;
+
+    for (int start=0; start<dataLen; start+=blockRunSize){
+        blockInsertionSort(data, start, std::min(start+blockRunSize, dataLen));
+    }
+
+    for (int width=blockRunSize; width<dataLen; width*=2){
+        // every block of a merge needs its own tag
+        while (std::min(2*width, dataLen)/blockLen > tagCount){
+            blockLen *= 2;
+        }
+        for (int start=0; start+width<dataLen; start+=2*width){
+            int mid = start + width;
+            int end = std::min(start + 2*width, dataLen);
+            // runs are already in order, nothing to merge
+            blockKeyComp++;
+            if (data[mid-1] <= data[mid]){
+                continue;
+            }
+            if (width < blockLen){
+                bool tailFromLeft;
+                if (width <= bufLen) swapMergeForward(data, start, width, end, buf, true, tailFromLeft);
+                else rotationMerge(data, start, mid, end);
+            }
+            else {
+                blockMerge(data, start, mid, end, blockLen, keys, buf, bufLen);
+            }
+        }
+    }
+
+    // the buffer part of the keys got shuffled by the swaps, sort the keys and put them back.
+    // keys go in front of equal data elements since they were the first occurrences
+    blockInsertionSort(arr, 0, keyCount);
+    rotationMerge(arr, 0, keyCount, len);
+}
+
+void blockInsertionSort(int* arr, int start, int end){
+    for (int i=start+1; i<end; i++){
+        int value = arr[i];
+        int j = i;
+        while (j > start){
+            blockKeyComp++;
+            if (value < arr[j-1]){
+                arr[j] = arr[j-1];
+                j--;
+            }
+            else break;
+        }
+        arr[j] = value;
+    }
+}
+
+void rotateRange(int* arr, int start, int mid, int end){
+    // rotate [start, end) left so that arr[mid] ends up at arr[start], 3 reversals need no extra memory
+    blockRotateMoves += end - start;
+    std::reverse(arr+start, arr+mid);
+    std::reverse(arr+mid, arr+end);
+    std::reverse(arr+start, arr+end);
+}
+
+int blockLowerBound(int* arr, int len, int value){
+    // first index with arr[i] >= value
+    int low = 0;
+    int high = len;
+    while (low < high){
+        int mid = low + (high-low)/2;
+        blockKeyComp++;
+        if (arr[mid] < value) low = mid+1;
+        else high = mid;
+    }
+    return low;
+}
+
+int blockUpperBound(int* arr, int len, int value){
+    // first index with arr[i] > value
+    int low = 0;
+    int high = len;
+    while (low < high){
+        int mid = low + (high-low)/2;
+        blockKeyComp++;
+        if (arr[mid] <= value) low = mid+1;
+        else high = mid;
+    }
+    return low;
+}
+
+int collectKeys(int* arr, int len, int wanted){
+    // gather up to wanted distinct values (first occurrences) into a sorted block at the front.
+    // the key block is rolled along the array with rotations so the other elements keep their order
+    int keysStart = 0;
+    int found = 1;
+    for (int i=1; i<len && found<wanted; i++){
+        int pos = blockLowerBound(arr+keysStart, found, arr[i]);
+        if (pos < found){
+            blockKeyComp++;
+            if (arr[keysStart+pos] == arr[i]) continue;
+        }
+        rotateRange(arr, keysStart, keysStart+found, i);
+        keysStart = i - found;
+        rotateRange(arr, keysStart+pos, i, i+1);
+        found++;
+    }
+    rotateRange(arr, 0, keysStart, keysStart+found);
+    return found;
+}
+
+int swapMergeForward(int* arr, int start, int leftLen, int end, int* buf, bool leftWinsTies, bool& tailFromLeft){
+    // merge [start, start+leftLen) with [start+leftLen, end), buf needs room for the left part.
+    // everything is swapped rather than copied so buf ends up with the same values it started with.
+    // returns where the unmerged tail starts (the part of whichever side was left over)
+    for (int k=0; k<leftLen; k++){
+        std::swap(arr[start+k], buf[k]);
+    }
+    int out = start;
+    int x = 0;
+    int y = start + leftLen;
+    while (x < leftLen && y < end){
+        blockKeyComp++;
+        bool takeLeft = leftWinsTies ? buf[x] <= arr[y] : buf[x] < arr[y];
+        if (takeLeft){
+            std::swap(arr[out++], buf[x++]);
+        }
+        else {
+            std::swap(arr[out++], arr[y++]);
+        }
+    }
+    tailFromLeft = x < leftLen;
+    int tail = tailFromLeft ? out : y;
+    while (x < leftLen){
+        std::swap(arr[out++], buf[x++]);
+    }
+    return tail;
+}
+
+void swapMergeBackward(int* arr, int start, int mid, int end, int* buf){
+    // same as swapMergeForward but the right part goes into buf and the merge runs from the back,
+    // used when the right run is the short one
+    int rightLen = end - mid;
+    for (int k=0; k<rightLen; k++){
+        std::swap(arr[mid+k], buf[k]);
+    }
+    int out = end - 1;
+    int x = mid - 1;
+    int y = rightLen - 1;
+    while (x >= start && y >= 0){
+        blockKeyComp++;
+        if (arr[x] > buf[y]){
+            std::swap(arr[out--], arr[x--]);
+        }
+        else {
+            std::swap(arr[out--], buf[y--]);
+        }
+    }
+    while (y >= 0){
+        std::swap(arr[out--], buf[y--]);
+    }
+}
+
+void rotationMerge(int* arr, int start, int mid, int end, bool leftWinsTies){
+    // in-place merge with no buffer at all: rotate the smaller right elements in front of the left run.
+    // ties keep the left elements first unless leftWinsTies is false
+    while (start < mid && mid < end){
+        int smaller = leftWinsTies ? blockLowerBound(arr+mid, end-mid, arr[start])
+                                   : blockUpperBound(arr+mid, end-mid, arr[start]);
+        if (smaller > 0){
+            rotateRange(arr, start, mid, mid+smaller);
+            start += smaller;
+            mid += smaller;
+        }
+        if (mid == end) break;
+        start += leftWinsTies ? blockUpperBound(arr+start, mid-start, arr[mid])
+                              : blockLowerBound(arr+start, mid-start, arr[mid]);
+    }
+}
+
+int rotationMergeForward(int* arr, int start, int leftLen, int end, bool leftWinsTies, bool& tailFromLeft){
+    // swapMergeForward for when the left part does not fit in the buffer: the tail is worked out
+    // from the last element of each run, then the runs are merged with rotations
+    int mid = start + leftLen;
+    int lastLeft = arr[mid-1];
+    int lastRight = arr[end-1];
+    blockKeyComp++;
+    tailFromLeft = leftWinsTies ? lastLeft > lastRight : lastLeft >= lastRight;
+    int tail;
+    if (tailFromLeft){
+        // the right run runs out first, left elements that come after its last element are the tail
+        int before = leftWinsTies ? blockUpperBound(arr+start, leftLen, lastRight)
+                                  : blockLowerBound(arr+start, leftLen, lastRight);
+        tail = end - (leftLen - before);
+    }
+    else {
+        int before = leftWinsTies ? blockLowerBound(arr+mid, end-mid, lastLeft)
+                                  : blockUpperBound(arr+mid, end-mid, lastLeft);
+        tail = mid + before;
+    }
+    rotationMerge(arr, start, mid, end, leftWinsTies);
+    return tail;
+}
+
+void rotationMergeSort(int* arr, int len, int* extBuffer, int extBufferLen){
+    for (int start=0; start<len; start+=blockRunSize){
+        blockInsertionSort(arr, start, std::min(start+blockRunSize, len));
+    }
+    for (int width=blockRunSize; width<len; width*=2){
+        for (int start=0; start+width<len; start+=2*width){
+            int mid = start + width;
+            int end = std::min(start + 2*width, len);
+            blockKeyComp++;
+            if (arr[mid-1] <= arr[mid]){
+                continue;
+            }
+            if (extBuffer != nullptr && width <= extBufferLen){
+                bool tailFromLeft;
+                swapMergeForward(arr, start, width, end, extBuffer, true, tailFromLeft);
+            }
+            else {
+                rotationMerge(arr, start, mid, end);
+            }
+        }
+    }
+}
+
+void blockMerge(int* arr, int start, int mid, int end, int blockLen, int* keys, int* buf, int bufLen){
+    // merge [start, mid) and [mid, end) where the left run is a whole number of blocks.
+    // keys[0..blockCount) are sorted distinct tags, buf has room for bufLen elements (normally a
+    // whole block, merges that don't fit use rotations)
+    int leftBlocks = (mid-start)/blockLen;
+    int rightBlocks = (end-mid)/blockLen;
+    int blockCount = leftBlocks + rightBlocks;
+    int blocksEnd = mid + rightBlocks*blockLen;
+
+    if (rightBlocks > 0){
+        // tags below midKey belong to blocks of the left run
+        int midKey = keys[leftBlocks];
+
+        // selection sort the blocks by first element, the tag breaks ties so left blocks go first
+        for (int i=0; i<blockCount; i++){
+            int minIdx = i;
+            for (int j=i+1; j<blockCount; j++){
+                blockKeyComp++;
+                int first = arr[start + j*blockLen];
+                int minFirst = arr[start + minIdx*blockLen];
+                if (first < minFirst || (first == minFirst && keys[j] < keys[minIdx])){
+                    minIdx = j;
+                }
+            }
+            if (minIdx != i){
+                std::swap_ranges(arr + start + i*blockLen, arr + start + (i+1)*blockLen, arr + start + minIdx*blockLen);
+                std::swap(keys[i], keys[minIdx]);
+            }
+        }
+
+        // walk the blocks keeping an unfinished fragment from one run, once the next block comes
+        // from the other run the two get merged and whatever is left over becomes the new fragment
+        int fragStart = start;
+        bool fragFromLeft = keys[0] < midKey;
+        for (int b=1; b<blockCount; b++){
+            int blockStart = start + b*blockLen;
+            bool fromLeft = keys[b] < midKey;
+            if (fromLeft == fragFromLeft || fragStart == blockStart){
+                fragStart = blockStart;
+                fragFromLeft = fromLeft;
+                continue;
+            }
+            bool tailFromFrag;
+            int fragLen = blockStart - fragStart;
+            if (fragLen <= bufLen){
+                fragStart = swapMergeForward(arr, fragStart, fragLen, blockStart+blockLen, buf, fragFromLeft, tailFromFrag);
+            }
+            else {
+                fragStart = rotationMergeForward(arr, fragStart, fragLen, blockStart+blockLen, fragFromLeft, tailFromFrag);
+            }
+            fragFromLeft = tailFromFrag ? fragFromLeft : fromLeft;
+        }
+
+        // put the tags back in order for the next merge
+        blockInsertionSort(keys, 0, blockCount);
+    }
+
+    // leftover right elements that did not fill a block
+    if (blocksEnd < end){
+        if (end - blocksEnd <= bufLen) swapMergeBackward(arr, start, blocksEnd, end, buf);
+        else rotationMerge(arr, start, blocksEnd, end);
+    }
+}
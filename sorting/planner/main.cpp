@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <cstdint>
+#include "../engines/SortPlanner.h"
+
+using std::cout, std::vector, std::string;
+using std::chrono::high_resolution_clock, std::chrono::duration_cast, std::chrono::nanoseconds;
+
+// benchmarks the planner against every fixed engine over a matrix of input distributions and sizes.
+// each cell is the median of `reps` runs, done for int32, int64 and float keys, results are appended
+// to timingsPlanner.csv.
+
+template <typename T> vector<T> makeInput(const string& distribution, int size);
+template <typename T> double timeSort(vector<T> input, const string& engine, SortPlan& plan);
+template <typename T> void benchmarkPlanner(const string& type, std::ofstream& file);
+
+vector<string> distributions = {"random", "sorted", "reversed", "nearlySorted", "fewUnique",
+                                "narrowRange", "organPipe", "sortedRuns", "allEqual"};
+vector<string> engines = {"hybrid", "merge", "quick", "radix", "runs", "quick3", "planner"};
+vector<int> sizes = {10000, 100000, 1000000};
+int reps = 3;
+
+int main(){
+    std::ofstream file;
+    file.open("timingsPlanner.csv", std::ios::app);
+    if (!file.is_open()) {
+        cout << "Error opening timingsPlanner.csv for writing.\n";
+        return 1;
+    }
+    file << "type,distribution,sampleSize,engine,timing,samplingTiming\n";
+    benchmarkPlanner<int32_t>("int32", file);
+    benchmarkPlanner<int64_t>("int64", file);
+    benchmarkPlanner<float>("float", file);
+    file.close();
+    cout << "All sorting operations completed.\n";
+    return 0;
+}
+
+template <typename T>
+void benchmarkPlanner(const string& type, std::ofstream& file){
+    for (const string& distribution : distributions) {
+        for (int size : sizes) {
+            vector<T> input = makeInput<T>(distribution, size);
+            string best;
+            double bestTiming = 0;
+            double plannerTiming = 0;
+            SortPlan plan;
+            for (const string& engine : engines) {
+                vector<double> timings;
+                for (int rep = 0; rep < reps; rep++) {
+                    timings.push_back(timeSort(input, engine, plan));
+                }
+                std::sort(timings.begin(), timings.end());
+                double timing = timings[reps/2];
+                file << type << "," << distribution << "," << size << "," << engine << "," << timing << ","
+                     << (engine == "planner" ? plan.samplingNs : 0) << "\n";
+                if (engine == "planner") {
+                    plannerTiming = timing;
+                }
+                else if (best.empty() || timing < bestTiming) {
+                    best = engine;
+                    bestTiming = timing;
+                }
+            }
+            cout << type << " " << distribution << " " << size << ": planner picked " << engineName(plan.engine)
+                 << " (" << plan.reason << ", sampling " << plan.samplingNs/1000 << " us) "
+                 << plannerTiming/1e6 << " ms, best fixed engine " << best << " " << bestTiming/1e6 << " ms\n";
+        }
+    }
+}
+
+template <typename T>
+vector<T> makeInput(const string& distribution, int size){
+    vector<T> input;
+    for (int i = 0; i < size; i++) {
+        if (distribution == "sorted") input.push_back(i);
+        else if (distribution == "reversed") input.push_back(size - i);
+        else if (distribution == "nearlySorted") input.push_back(i);
+        else if (distribution == "fewUnique") input.push_back(rand() % 10 * 1000003);
+        else if (distribution == "narrowRange") input.push_back(rand() % 1000);
+        else if (distribution == "organPipe") input.push_back(i < size/2 ? i : size - i);
+        else if (distribution == "sortedRuns") input.push_back(i % (size/16 + 1) + rand() % 4);
+        else if (distribution == "allEqual") input.push_back(42);
+        else input.push_back((T)((int64_t)rand() * rand() - (int64_t)rand() * rand()));
+    }
+    if (distribution == "nearlySorted") {
+        // 1% of the elements swapped with a random partner
+        for (int k = 0; k < size/100; k++) {
+            std::swap(input[rand() % size], input[rand() % size]);
+        }
+    }
+    if (distribution == "sortedRuns") {
+        // 16 ascending runs: sort each block of the sawtooth so only the run boundaries are out of order
+        int run = size/16 + 1;
+        for (int start = 0; start < size; start += run) {
+            std::sort(input.begin() + start, input.begin() + std::min(start + run, size));
+        }
+    }
+    return input;
+}
+
+template <typename T>
+double timeSort(vector<T> input, const string& engine, SortPlan& plan){
+    auto start = high_resolution_clock::now();
+    if (engine == "planner") {
+        plan = plannedSort(input.data(), input.size());
+    }
+    else {
+        Engine fixed = Engine::Hybrid;
+        parseEngine(engine, fixed);
+        sortArray(input.data(), input.size(), fixed, 1);
+    }
+    auto stop = high_resolution_clock::now();
+    if (!std::is_sorted(input.begin(), input.end())) {
+        cout << engine << " did not sort the input!\n";
+    }
+    return duration_cast<nanoseconds>(stop - start).count();
+}
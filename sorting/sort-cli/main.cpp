@@ -0,0 +1,294 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../engines/SortPlanner.h"
+
+using std::cout, std::cerr, std::string;
+using std::chrono::high_resolution_clock, std::chrono::duration_cast, std::chrono::nanoseconds;
+
+// sortcli: sorts a binary file of int32/int64/float values (native byte order).
+//
+//   sortcli [-t int32|int64|float] [-e auto|hybrid|merge|quick|radix|runs|quick3] [-j threads] [-o output] [-c] [--trace trace.json] [input]
+//
+// with an input file and no -o the file is mmap'd and sorted in place. with -o the input is mapped
+// read-only and copied once into the mapped output file, which is then sorted; an -o that names the
+// input file itself sorts it in place. without an input file (or with "-") stdin is used and the
+// result goes to -o or stdout. -j 0 uses every core,
+// -c checks the result is sorted. float input containing NaNs is rejected, since the engines
+// would each leave them somewhere else. -e auto lets the planner pick the engine from a sample of the
+// input and logs its decision. --trace records the recursion of the sort (all threads) and writes it
+// as a Chrome trace, with a per-depth summary on stderr. timing and throughput go to stderr.
+
+struct Options {
+    string type = "int32";
+    Engine engine = Engine::Hybrid;
+    bool autoEngine = false;
+    int threads = 1;
+    string input;
+    string output;
+    bool check = false;
+    string trace;
+};
+
+struct Mapping {
+    char* data = nullptr;
+    size_t size = 0;
+};
+
+void printUsage();
+bool parseArgs(int argc, char* argv[], Options& options);
+bool mapFile(int fd, size_t size, bool writable, bool shared, Mapping& mapping);
+bool readAll(int fd, std::vector<char>& bytes);
+bool writeAll(int fd, const char* data, size_t size);
+template <typename T> bool sortBytes(char* data, size_t size, const Options& options);
+
+int main(int argc, char* argv[]){
+    Options options;
+    if (!parseArgs(argc, argv, options)){
+        printUsage();
+        return 1;
+    }
+
+    bool fromStdin = options.input.empty() || options.input == "-";
+    if (!options.output.empty()){
+        // -o naming the input file itself (or the file redirected to stdin) would truncate the input
+        // under its own mapping, so that case is sorted in place instead
+        struct stat sourceStat;
+        struct stat targetStat;
+        bool sourceKnown = fromStdin ? fstat(0, &sourceStat) == 0 : stat(options.input.c_str(), &sourceStat) == 0;
+        if (sourceKnown && S_ISREG(sourceStat.st_mode) && stat(options.output.c_str(), &targetStat) == 0
+            && sourceStat.st_dev == targetStat.st_dev && sourceStat.st_ino == targetStat.st_ino){
+            options.input = options.output;
+            options.output.clear();
+            fromStdin = false;
+        }
+    }
+    bool inPlace = !fromStdin && options.output.empty();
+
+    int inFd = 0;
+    if (!fromStdin){
+        inFd = open(options.input.c_str(), inPlace ? O_RDWR : O_RDONLY);
+        if (inFd < 0){
+            cerr << "Error opening " << options.input << ": " << strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    struct stat inStat;
+    if (fstat(inFd, &inStat) != 0){
+        cerr << "Error reading input size: " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    // a pipe on stdin can't be mapped, so it gets read into memory instead
+    std::vector<char> stdinBytes;
+    Mapping input;
+    if (S_ISREG(inStat.st_mode)){
+        input.size = inStat.st_size;
+        // in place writes straight back to the file, for stdout a private (copy on write) mapping is enough
+        bool writable = inPlace || options.output.empty();
+        if (!mapFile(inFd, input.size, writable, inPlace, input)) return 1;
+    }
+    else {
+        if (!readAll(inFd, stdinBytes)) return 1;
+        input.data = stdinBytes.data();
+        input.size = stdinBytes.size();
+    }
+
+    // data is what gets sorted: the input mapping itself, or the mapped output file
+    char* data = input.data;
+    Mapping output;
+    int outFd = -1;
+    if (!options.output.empty()){
+        outFd = open(options.output.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (outFd < 0){
+            cerr << "Error opening " << options.output << ": " << strerror(errno) << "\n";
+            return 1;
+        }
+        if (ftruncate(outFd, input.size) != 0){
+            cerr << "Error sizing " << options.output << ": " << strerror(errno) << "\n";
+            return 1;
+        }
+        if (!mapFile(outFd, input.size, true, true, output)) return 1;
+        if (input.size > 0) std::memcpy(output.data, input.data, input.size);
+        data = output.data;
+    }
+
+    bool sorted;
+    if (options.type == "int32") sorted = sortBytes<int32_t>(data, input.size, options);
+    else if (options.type == "int64") sorted = sortBytes<int64_t>(data, input.size, options);
+    else sorted = sortBytes<float>(data, input.size, options);
+    if (!sorted) return 1;
+
+    if (!inPlace && options.output.empty()){
+        if (!writeAll(1, data, input.size)) return 1;
+    }
+
+    // unmapping a shared mapping is what writes the sorted data back
+    if (output.data != nullptr) munmap(output.data, output.size);
+    if (input.data != nullptr && stdinBytes.empty()) munmap(input.data, input.size);
+    if (outFd >= 0) close(outFd);
+    if (inFd > 0) close(inFd);
+    return 0;
+}
+
+void printUsage(){
+    cerr << "usage: sortcli [-t int32|int64|float] [-e auto|hybrid|merge|quick|radix|runs|quick3] [-j threads] [-o output] [-c] [--trace trace.json] [input]\n";
+}
+
+bool parseArgs(int argc, char* argv[], Options& options){
+    for (int i=1; i<argc; i++){
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-t" && hasValue){
+            options.type = argv[++i];
+            if (options.type != "int32" && options.type != "int64" && options.type != "float"){
+                cerr << "Unknown type " << options.type << "\n";
+                return false;
+            }
+        }
+        else if (arg == "-e" && hasValue){
+            string name = argv[++i];
+            options.autoEngine = name == "auto";
+            if (!options.autoEngine && !parseEngine(name, options.engine)){
+                cerr << "Unknown engine " << name << "\n";
+                return false;
+            }
+        }
+        else if (arg == "-j" && hasValue){
+            options.threads = atoi(argv[++i]);
+            if (options.threads <= 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else if (arg == "-o" && hasValue){
+            options.output = argv[++i];
+        }
+        else if (arg == "--trace" && hasValue){
+            options.trace = argv[++i];
+        }
+        else if (arg == "-c"){
+            options.check = true;
+        }
+        else if (arg == "-h" || arg == "--help"){
+            return false;
+        }
+        else if (options.input.empty() && (arg == "-" || arg[0] != '-')){
+            options.input = arg;
+        }
+        else {
+            cerr << "Unexpected argument " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool mapFile(int fd, size_t size, bool writable, bool shared, Mapping& mapping){
+    mapping.size = size;
+    if (size == 0) return true;
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* addr = mmap(nullptr, size, prot, shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED){
+        cerr << "Error mapping file: " << strerror(errno) << "\n";
+        return false;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+    mapping.data = (char*)addr;
+    return true;
+}
+
+bool readAll(int fd, std::vector<char>& bytes){
+    size_t used = 0;
+    bytes.resize(1 << 20);
+    while (true){
+        if (used == bytes.size()) bytes.resize(bytes.size()*2);
+        ssize_t got = read(fd, bytes.data() + used, bytes.size() - used);
+        if (got < 0){
+            if (errno == EINTR) continue;
+            cerr << "Error reading stdin: " << strerror(errno) << "\n";
+            return false;
+        }
+        if (got == 0) break;
+        used += got;
+    }
+    bytes.resize(used);
+    return true;
+}
+
+bool writeAll(int fd, const char* data, size_t size){
+    while (size > 0){
+        ssize_t written = write(fd, data, size);
+        if (written < 0){
+            if (errno == EINTR) continue;
+            cerr << "Error writing output: " << strerror(errno) << "\n";
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+template <typename T>
+bool sortBytes(char* data, size_t size, const Options& options){
+    if (size % sizeof(T) != 0){
+        cerr << "Input is " << size << " bytes, not a whole number of " << options.type << " values\n";
+        return false;
+    }
+    // mmap'd memory is page aligned and vector memory comes from new, so the cast is safe
+    T* arr = (T*)data;
+    size_t n = size/sizeof(T);
+    if constexpr (std::is_floating_point_v<T>){
+        // the engines compare with <, which leaves NaNs wherever each algorithm happens to put them
+        // (radix alone orders them by their bits), so NaN input is refused instead of sorted
+        // differently per engine. not counted in the sort time
+        for (size_t i=0; i<n; i++){
+            if (std::isnan(arr[i])){
+                cerr << "Input has a NaN at element " << i << ", float input must not contain NaNs\n";
+                return false;
+            }
+        }
+    }
+
+    // the planner's sampling counts towards the sort time
+    sortTraceEnabled = !options.trace.empty();
+    auto start = high_resolution_clock::now();
+    Engine engine = options.engine;
+    if (options.autoEngine){
+        plannerLog = true;
+        engine = planSort(arr, n).engine;
+    }
+    sortArray(arr, n, engine, options.threads);
+    auto stop = high_resolution_clock::now();
+    double seconds = duration_cast<nanoseconds>(stop - start).count() / 1e9;
+    sortTraceEnabled = false;
+
+    cerr << "sorted " << n << " " << options.type << " values (" << size/1e6 << " MB) with "
+         << engineName(engine) << " on " << options.threads << " thread(s) in "
+         << seconds*1000 << " ms, " << (seconds > 0 ? size/1e6/seconds : 0) << " MB/s\n";
+
+    if (!options.trace.empty()){
+        printTraceSummary(cerr);
+        if (!writeChromeTrace(options.trace, engineName(engine))){
+            cerr << "Error opening " << options.trace << " for writing\n";
+            return false;
+        }
+    }
+
+    if (options.check){
+        for (size_t i=1; i<n; i++){
+            if (arr[i] < arr[i-1]){
+                cerr << "Check failed: element " << i << " is out of order\n";
+                return false;
+            }
+        }
+        cerr << "Check passed\n";
+    }
+    return true;
+}
@@ -0,0 +1,295 @@
+#ifndef SORTINGNETWORKS_H
+#define SORTINGNETWORKS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// compile-time sorting networks for sizes up to 32, expanded into straight-line compare-swaps.
+// sizes 2..16 use the smallest known networks (16 is Green's 60 comparator network). bigger sizes
+// are split in two, both parts are sorted with the best network available and joined with Batcher's
+// odd-even merge; the split is chosen at compile time to use the fewest comparators (e.g. 32 -> 185).
+//
+//   sort_fixed<N>(arr)     sorts arr[0..N) when N is known at compile time
+//   sort_small(arr, n)     picks the network for a runtime n <= 32
+//   network_size(n)        comparators (= key comparisons) used for size n
+
+const int maxNetworkSize = 32;
+const int maxComparators = 256;
+
+struct Comparator {
+    int a;
+    int b;
+};
+
+struct ComparatorNetwork {
+    int size = 0;
+    Comparator comps[maxComparators] = {};
+
+    constexpr void add(int a, int b){
+        comps[size].a = a;
+        comps[size].b = b;
+        size++;
+    }
+};
+
+// smallest known networks, listed layer by layer
+constexpr Comparator network2[] = {{0,1}};
+constexpr Comparator network3[] = {{0,2}, {0,1}, {1,2}};
+constexpr Comparator network4[] = {{0,1},{2,3}, {0,2},{1,3}, {1,2}};
+constexpr Comparator network5[] = {{0,3},{1,4}, {0,2},{1,3}, {0,1},{2,4}, {1,2},{3,4}, {2,3}};
+constexpr Comparator network6[] = {{0,5},{1,3},{2,4}, {1,2},{3,4}, {0,3},{2,5}, {0,1},{2,3},{4,5}, {1,2},{3,4}};
+constexpr Comparator network7[] = {{0,6},{2,3},{4,5}, {0,2},{1,4},{3,6}, {0,1},{2,5},{3,4}, {1,2},{4,6},
+                                   {2,3},{4,5}, {1,2},{3,4},{5,6}};
+constexpr Comparator network8[] = {{0,2},{1,3},{4,6},{5,7}, {0,4},{1,5},{2,6},{3,7}, {0,1},{2,3},{4,5},{6,7},
+                                   {2,4},{3,5}, {1,4},{3,6}, {1,2},{3,4},{5,6}};
+constexpr Comparator network9[] = {{0,3},{1,7},{2,5},{4,8}, {0,7},{2,4},{3,8},{5,6}, {0,2},{1,3},{4,5},{7,8},
+                                   {1,4},{3,6},{5,7}, {0,1},{2,4},{3,5},{6,8}, {2,3},{4,5},{6,7},
+                                   {1,2},{3,4},{5,6}};
+constexpr Comparator network10[] = {{0,8},{1,9},{2,7},{3,5},{4,6}, {0,2},{1,4},{5,8},{7,9},
+                                    {0,3},{2,4},{5,7},{6,9}, {0,1},{3,6},{8,9}, {1,5},{2,3},{4,8},{6,7},
+                                    {1,2},{3,5},{4,6},{7,8}, {2,3},{4,5},{6,7}, {3,4},{5,6}};
+constexpr Comparator network11[] = {{0,9},{1,6},{2,4},{3,7},{5,8}, {0,1},{3,5},{4,10},{6,9},{7,8},
+                                    {1,3},{2,5},{4,7},{8,10}, {0,4},{1,2},{3,7},{5,9},{6,8},
+                                    {0,1},{2,6},{4,5},{7,8},{9,10}, {2,4},{3,6},{5,7},{8,9},
+                                    {1,2},{3,4},{5,6},{7,8}, {2,3},{4,5},{6,7}};
+constexpr Comparator network12[] = {{0,8},{1,7},{2,6},{3,11},{4,10},{5,9},
+                                    {0,1},{2,5},{3,4},{6,9},{7,8},{10,11}, {0,2},{1,6},{5,10},{9,11},
+                                    {0,3},{1,2},{4,6},{5,7},{8,11},{9,10}, {1,4},{3,5},{6,8},{7,10},
+                                    {1,3},{2,5},{6,9},{8,10}, {2,3},{4,5},{6,7},{8,9}, {4,6},{5,7},
+                                    {3,4},{5,6},{7,8}};
+constexpr Comparator network13[] = {{0,12},{1,10},{2,9},{3,7},{5,11},{6,8}, {1,6},{2,3},{4,11},{7,9},{8,10},
+                                    {0,4},{1,2},{3,6},{7,8},{9,10},{11,12}, {4,6},{5,9},{8,11},{10,12},
+                                    {0,5},{3,8},{4,7},{6,11},{9,10}, {0,1},{2,5},{6,9},{7,8},{10,11},
+                                    {1,3},{2,4},{5,6},{9,10}, {1,2},{3,4},{5,7},{6,8}, {2,3},{4,5},{6,7},{8,9},
+                                    {3,4},{5,6}};
+constexpr Comparator network14[] = {{0,1},{2,3},{4,5},{6,7},{8,9},{10,11},{12,13},
+                                    {0,2},{1,3},{4,8},{5,9},{10,12},{11,13},
+                                    {0,4},{1,2},{3,7},{5,8},{6,10},{9,13},{11,12},
+                                    {0,6},{1,5},{3,9},{4,10},{7,13},{8,12}, {2,10},{3,11},{4,6},{7,9},
+                                    {1,3},{2,8},{5,11},{6,7},{10,12}, {1,4},{2,6},{3,5},{7,11},{8,10},{9,12},
+                                    {2,4},{3,6},{5,8},{7,10},{9,11}, {3,4},{5,6},{7,8},{9,10}, {6,7}};
+constexpr Comparator network15[] = {{0,11},{1,14},{2,13},{3,7},{4,5},{6,10},{8,9},
+                                    {0,6},{1,8},{2,3},{5,12},{7,13},{9,14},{10,11},
+                                    {1,2},{3,4},{5,7},{6,8},{9,10},{11,12},{13,14},
+                                    {0,2},{3,9},{4,10},{5,6},{7,8},{11,13},{12,14},
+                                    {0,1},{2,11},{3,5},{4,6},{7,9},{8,10},{12,13},
+                                    {0,3},{1,5},{4,7},{6,9},{8,12},{10,13}, {1,3},{2,5},{8,11},{10,12},
+                                    {2,4},{5,7},{6,8},{9,11}, {2,3},{4,5},{6,7},{8,9},{10,11}, {5,6},{7,8}};
+constexpr Comparator network16[] = {{0,13},{1,12},{2,15},{3,14},{4,8},{5,6},{7,11},{9,10},
+                                    {0,5},{1,7},{2,9},{3,4},{6,13},{8,14},{10,15},{11,12},
+                                    {0,1},{2,3},{4,5},{6,8},{7,9},{10,11},{12,13},{14,15},
+                                    {0,2},{1,3},{4,10},{5,11},{6,7},{8,9},{12,14},{13,15},
+                                    {1,2},{3,12},{4,6},{5,7},{8,10},{9,11},{13,14},
+                                    {1,4},{2,6},{5,8},{7,10},{9,13},{11,14}, {2,4},{3,6},{9,12},{11,13},
+                                    {3,5},{6,8},{7,9},{10,12}, {3,4},{5,6},{7,8},{9,10},{11,12}, {6,7},{8,9}};
+
+struct KnownNetwork {
+    const Comparator* comps = nullptr;
+    int size = 0;
+};
+
+template <std::size_t Len>
+constexpr KnownNetwork known(const Comparator (&comps)[Len]){
+    return {comps, (int)Len};
+}
+
+// indexed by size, sizes without an entry are built by makeNetworkPlan
+constexpr KnownNetwork knownNetworks[maxNetworkSize+1] = {
+    {}, {}, known(network2), known(network3), known(network4), known(network5), known(network6),
+    known(network7), known(network8), known(network9), known(network10), known(network11), known(network12),
+    known(network13), known(network14), known(network15), known(network16)};
+
+constexpr void addAll(ComparatorNetwork& net, const KnownNetwork& network, int offset){
+    for (int i=0; i<network.size; i++){
+        net.add(network.comps[i].a + offset, network.comps[i].b + offset);
+    }
+}
+
+constexpr int addOddEvenMerge(ComparatorNetwork* net, int a, int b, int offset){
+    // Batcher's odd-even merge of a sorted run of a elements followed by one of b elements.
+    // it is generated for two power-of-two halves with the low run sitting at the top of the first
+    // half (below it is -inf padding) and the high run at the bottom of the second half (+inf
+    // padding after it); comparators touching the padding never swap, so they are dropped.
+    // returns the number of comparators, only adds them when net is given
+    int half = 1;
+    while (half < a || half < b){
+        half *= 2;
+    }
+    int padded = 2*half;
+    int low = half - a;
+    int high = half + b;
+    int count = 0;
+    for (int k=half; k>=1; k/=2){
+        for (int j=k%half; j<=padded-1-k; j+=2*k){
+            for (int i=0; i<k && i+j+k<padded; i++){
+                int x = i + j;
+                int y = i + j + k;
+                if (x >= low && y < high){
+                    if (net != nullptr) net->add(x - low + offset, y - low + offset);
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+struct NetworkPlan {
+    int cost[maxNetworkSize+1] = {};
+    int split[maxNetworkSize+1] = {};
+};
+
+constexpr NetworkPlan makeNetworkPlan(){
+    // sizes without a known network are split into two parts sorted on their own and merged,
+    // pick the split that needs the fewest comparators in total
+    NetworkPlan plan;
+    for (int n=0; n<=maxNetworkSize; n++){
+        if (n < 2 || knownNetworks[n].comps != nullptr){
+            plan.cost[n] = knownNetworks[n].size;
+            continue;
+        }
+        plan.cost[n] = -1;
+        for (int a=1; a<n; a++){
+            int cost = plan.cost[a] + plan.cost[n-a] + addOddEvenMerge(nullptr, a, n-a, 0);
+            if (plan.cost[n] < 0 || cost < plan.cost[n]){
+                plan.cost[n] = cost;
+                plan.split[n] = a;
+            }
+        }
+    }
+    return plan;
+}
+
+constexpr NetworkPlan networkPlan = makeNetworkPlan();
+
+constexpr void addNetwork(ComparatorNetwork& net, int n, int offset){
+    if (n < 2) return;
+    if (knownNetworks[n].comps != nullptr){
+        addAll(net, knownNetworks[n], offset);
+        return;
+    }
+    int a = networkPlan.split[n];
+    addNetwork(net, a, offset);
+    addNetwork(net, n - a, offset + a);
+    addOddEvenMerge(&net, a, n - a, offset);
+}
+
+constexpr ComparatorNetwork makeNetwork(int n){
+    ComparatorNetwork net;
+    addNetwork(net, n, 0);
+    return net;
+}
+
+constexpr bool sortsZeroOne(const ComparatorNetwork& net, int n){
+    // 0-1 principle: a network that sorts every input of 0s and 1s sorts everything. the 2^n inputs
+    // are packed 64 to a word: bit k of wires[i] is wire i of input word*64 + k
+    const uint64_t patterns[6] = {0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+                                  0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull};
+    const uint64_t valid = n >= 6 ? ~0ull : (1ull << (1 << n)) - 1;
+    const uint64_t words = n <= 6 ? 1 : 1ull << (n - 6);
+    for (uint64_t word=0; word<words; word++){
+        uint64_t wires[maxNetworkSize] = {};
+        for (int i=0; i<n; i++){
+            wires[i] = i < 6 ? patterns[i] : ((word >> (i - 6)) & 1 ? ~0ull : 0);
+        }
+        for (int c=0; c<net.size; c++){
+            const uint64_t x = wires[net.comps[c].a];
+            const uint64_t y = wires[net.comps[c].b];
+            wires[net.comps[c].a] = x & y;
+            wires[net.comps[c].b] = x | y;
+        }
+        for (int i=0; i+1<n; i++){
+            if (wires[i] & ~wires[i+1] & valid) return false;
+        }
+    }
+    return true;
+}
+
+inline bool sortsRandomZeroOne(const ComparatorNetwork& net, int n, int trials, uint64_t seed){
+    // sampled version of sortsZeroOne for sizes where 2^n inputs are too many. each trial shuffles
+    // 0..n-1 and packs its n+1 threshold inputs into one word: bit k of wires[i] is set when
+    // value i >= k. the network sorts all of them exactly when it sorts the permutation itself
+    const uint64_t valid = n >= 63 ? ~0ull : (1ull << (n + 1)) - 1;
+    int values[maxNetworkSize];
+    for (int t=0; t<trials; t++){
+        for (int i=0; i<n; i++){
+            // xorshift64, then a Fisher-Yates step
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            int j = (int)(seed % (uint64_t)(i + 1));
+            values[i] = values[j];
+            values[j] = i;
+        }
+        uint64_t wires[maxNetworkSize] = {};
+        for (int i=0; i<n; i++){
+            // lanes 0..values[i] see a 1 on wire i
+            wires[i] = (values[i] + 1 >= 64 ? ~0ull : (1ull << (values[i] + 1)) - 1) & valid;
+        }
+        for (int c=0; c<net.size; c++){
+            const uint64_t x = wires[net.comps[c].a];
+            const uint64_t y = wires[net.comps[c].b];
+            wires[net.comps[c].a] = x & y;
+            wires[net.comps[c].b] = x | y;
+        }
+        for (int i=0; i+1<n; i++){
+            if (wires[i] & ~wires[i+1]) return false;
+        }
+    }
+    return true;
+}
+
+template <int N>
+struct NetworkFor {
+    static_assert(N >= 0 && N <= maxNetworkSize, "sorting networks only go up to 32 elements");
+    static constexpr ComparatorNetwork net = makeNetwork(N);
+    static_assert(net.size == networkPlan.cost[N], "network does not match its plan");
+    // checking all 2^N inputs is cheap enough to do while compiling up to 16 elements,
+    // bigger sizes are checked by the hybrid-sort tests
+    static_assert(N > 16 || sortsZeroOne(net, N), "network does not sort");
+};
+
+constexpr int network_size(int n){
+    return networkPlan.cost[n];
+}
+
+template <int A, int B, typename T>
+inline void compareSwap(T* arr){
+    // written as selects so the compiler emits min/max (cmov) instead of a branch
+    const T x = arr[A];
+    const T y = arr[B];
+    const bool swapped = y < x;
+    arr[A] = swapped ? y : x;
+    arr[B] = swapped ? x : y;
+}
+
+template <int N, typename T, std::size_t... I>
+inline void applyNetwork([[maybe_unused]] T* arr, std::index_sequence<I...>){
+    (compareSwap<NetworkFor<N>::net.comps[I].a, NetworkFor<N>::net.comps[I].b>(arr), ...);
+}
+
+template <int N, typename T>
+inline void sort_fixed(T* arr){
+    applyNetwork<N>(arr, std::make_index_sequence<NetworkFor<N>::net.size>{});
+}
+
+template <typename T, std::size_t N>
+inline void sort_fixed(std::array<T, N>& arr){
+    sort_fixed<(int)N>(arr.data());
+}
+
+template <typename T, std::size_t... N>
+constexpr std::array<void (*)(T*), sizeof...(N)> makeNetworkTable(std::index_sequence<N...>){
+    return {{ &sort_fixed<(int)N, T>... }};
+}
+
+template <typename T>
+inline void sort_small(T* arr, int n){
+    // n must be <= maxNetworkSize
+    static constexpr auto table = makeNetworkTable<T>(std::make_index_sequence<maxNetworkSize+1>{});
+    table[n](arr);
+}
+
+#endif // SORTINGNETWORKS_H
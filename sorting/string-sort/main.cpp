@@ -0,0 +1,147 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include "../engines/StringSort.h"
+
+using std::cout, std::vector, std::string;
+using std::chrono::high_resolution_clock, std::chrono::duration_cast, std::chrono::nanoseconds;
+
+// benchmarks the string engines against the generic path: std::sort on a vector<std::string>
+// ("strings") and std::sort on the arena slots with a plain comparator ("slots", same memory layout
+// as the engines, so it separates the layout from the algorithm). each cell is the median of `reps`
+// runs and every result is checked against the std::sort order. results are appended to
+// timingsStrings.csv.
+// usage: ./a.out [threads], with threads > 1 the engines also run through the parallel lcp merge
+
+vector<string> makeStrings(const string& dataset, int size);
+double timeGeneric(const vector<string>& input, vector<string>& sorted);
+double timeEngine(const StringArena& input, const string& engine, int threads, StringArena& sorted);
+bool sameOrder(const StringArena& arena, const vector<string>& expected);
+
+vector<string> datasets = {"urls", "identifiers", "random", "duplicates"};
+vector<string> engines = {"strings", "slots", "multikey", "msd", "lcpmerge"};
+vector<int> sizes = {100000, 1000000};
+int reps = 3;
+
+int main(int argc, char* argv[]){
+    int threads = argc > 1 ? atoi(argv[1]) : 1;
+    std::ofstream file;
+    file.open("timingsStrings.csv", std::ios::app);
+    if (!file.is_open()) {
+        cout << "Error opening timingsStrings.csv for writing.\n";
+        return 1;
+    }
+    file << "dataset,sampleSize,engine,threads,timing\n";
+    bool allSorted = true;
+    for (const string& dataset : datasets) {
+        for (int size : sizes) {
+            vector<string> input = makeStrings(dataset, size);
+            StringArena arena;
+            size_t totalBytes = 0;
+            for (const string& s : input) totalBytes += s.size();
+            arena.reserve(input.size(), totalBytes);
+            for (const string& s : input) arena.add(s);
+
+            vector<string> expected;
+            cout << dataset << " " << size << ":";
+            for (const string& engine : engines) {
+                int engineThreads = engine == "strings" || engine == "slots" ? 1 : threads;
+                vector<double> timings;
+                for (int rep = 0; rep < reps; rep++) {
+                    if (engine == "strings") {
+                        timings.push_back(timeGeneric(input, expected));
+                        continue;
+                    }
+                    StringArena sorted;
+                    timings.push_back(timeEngine(arena, engine, engineThreads, sorted));
+                    if (rep == 0 && !sameOrder(sorted, expected)) {
+                        cout << "\n" << engine << " gave the wrong order for " << dataset << " " << size << "\n";
+                        allSorted = false;
+                    }
+                }
+                std::sort(timings.begin(), timings.end());
+                double timing = timings[reps/2];
+                file << dataset << "," << size << "," << engine << "," << engineThreads << "," << timing << "\n";
+                cout << " " << engine << " " << timing / 1e6 << "ms";
+            }
+            cout << "\n";
+        }
+    }
+    file.close();
+    if (!allSorted) return 1;
+    cout << "All sorting operations completed.\n";
+    return 0;
+}
+
+vector<string> makeStrings(const string& dataset, int size){
+    // urls and identifiers share long prefixes, which is where re-scanning them in every comparison hurts
+    vector<string> words = {"index", "products", "search", "api", "v2", "users", "images", "static",
+                            "blog", "2023", "category", "item", "download", "docs", "en", "account"};
+    vector<string> prefixes = {"user_", "order_", "session_", "invoice_", "customer_account_"};
+    vector<string> strings;
+    strings.reserve(size);
+    if (dataset == "duplicates") {
+        // every url drawn from a pool of 1000 distinct ones
+        vector<string> pool = makeStrings("urls", 1000);
+        for (int i = 0; i < size; i++) strings.push_back(pool[rand() % pool.size()]);
+        return strings;
+    }
+    srand(size);
+    for (int i = 0; i < size; i++) {
+        string s;
+        if (dataset == "urls") {
+            s = "https://www." + std::to_string(rand() % 50) + "-example.com";
+            int segments = 1 + rand() % 4;
+            for (int j = 0; j < segments; j++) s += "/" + words[rand() % words.size()];
+            s += "?id=" + std::to_string(rand() % 1000000);
+        }
+        else if (dataset == "identifiers") {
+            string number = std::to_string(rand() % 100000000);
+            s = prefixes[rand() % prefixes.size()] + string(10 - number.size(), '0') + number;
+        }
+        else {
+            int len = 4 + rand() % 17;
+            for (int j = 0; j < len; j++) s += (char)('a' + rand() % 26);
+        }
+        strings.push_back(s);
+    }
+    return strings;
+}
+
+double timeGeneric(const vector<string>& input, vector<string>& sorted){
+    sorted = input;
+    auto start = high_resolution_clock::now();
+    std::sort(sorted.begin(), sorted.end());
+    auto stop = high_resolution_clock::now();
+    return duration_cast<nanoseconds>(stop - start).count();
+}
+
+double timeEngine(const StringArena& input, const string& engine, int threads, StringArena& sorted){
+    sorted = input;
+    const unsigned char* base = sorted.bytes.data();
+    auto start = high_resolution_clock::now();
+    if (engine == "slots") {
+        std::sort(sorted.slots.begin(), sorted.slots.end(), [base](const StringSlot& a, const StringSlot& b){
+            return lessFrom(base, a, b, 0);
+        });
+    }
+    else {
+        StringEngine stringEngine = StringEngine::Multikey;
+        parseStringEngine(engine, stringEngine);
+        sortStrings(sorted, stringEngine, threads);
+    }
+    auto stop = high_resolution_clock::now();
+    return duration_cast<nanoseconds>(stop - start).count();
+}
+
+bool sameOrder(const StringArena& arena, const vector<string>& expected){
+    if (arena.size() != expected.size()) return false;
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (arena[i] != expected[i]) return false;
+    }
+    return true;
+}